@@ -0,0 +1,218 @@
+//============================================================================
+// Name        : ArrayTripleBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Triple buffer of runtime sized arrays in one cache aligned allocation
+//============================================================================
+
+#ifndef ARRAYTRIPLEBUFFER_HXX_
+#define ARRAYTRIPLEBUFFER_HXX_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+// view over a slot, with the subset of the C++20 std::span interface the buffers need
+template <typename T>
+class Span
+{
+
+public:
+
+	Span() : ptr(nullptr), count(0) {}
+	Span(T* data, size_t size) : ptr(data), count(size) {}
+
+	T* data() const { return ptr; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T& operator[](size_t i) const { return ptr[i]; }
+	T* begin() const { return ptr; }
+	T* end() const { return ptr + count; }
+
+private:
+
+	T* ptr;
+	size_t count;
+};
+
+// raw memory for three slots of count elements, each starting on a cache line
+// boundary; sets stride (elements between two slots) and memory (to release with
+// ::operator delete) and returns the first slot
+template <typename T>
+T* allocateSlots(size_t count, size_t& stride, void*& memory);
+
+// Triple buffer of arrays whose length is only known at runtime. The three slots
+// live in one allocation and each one starts on a cache line boundary, so they
+// can be handed to vectorized code as aligned arrays.
+template <typename T>
+class ArrayTripleBuffer
+{
+
+public:
+
+	ArrayTripleBuffer<T>(size_t size);
+	ArrayTripleBuffer<T>(size_t size, const T& init);
+	~ArrayTripleBuffer<T>();
+
+	// non-copyable behavior
+	ArrayTripleBuffer<T>(const ArrayTripleBuffer<T>&) = delete;
+	ArrayTripleBuffer<T>& operator=(const ArrayTripleBuffer<T>&) = delete;
+
+	size_t size() const; // number of elements in each slot
+
+	Span<const T> snap() const; // get the current snap to read
+	Span<T> dirty(); // get the dirty slot to write into in place
+	void write(const T* newT); // write size() new elements
+	bool newSnap(); // swap to the latest value, if any
+	void flipWriter(); // flip writer positions dirty / clean
+
+	Span<const T> readLast(); // wrapper to read the last available array (newSnap + snap)
+	void update(const T* newT); // wrapper to update with new elements (write + flipWriter)
+
+private:
+
+	void allocate(const T& init); // allocate and construct the three slots
+
+	TripleBufferFlags flags; // dirty / clean / snap indexes
+
+	size_t count; // elements per slot
+	size_t stride; // elements between the start of two slots, a whole number of cache lines
+	void* memory; // allocation holding the three slots
+	T* slots; // first slot, aligned to a cache line
+};
+
+// include implementation in header since it is a template
+
+template <typename T>
+T* allocateSlots(size_t count, size_t& stride, void*& memory){
+
+	static_assert(TRIPLEBUFFER_CACHE_LINE_SIZE % alignof(T) == 0, "T is over-aligned for a cache line");
+
+	size_t line(TRIPLEBUFFER_CACHE_LINE_SIZE);
+	size_t bytes((count * sizeof(T) + line - 1) / line * line);
+
+	// keep each slot a whole number of cache lines so all of them stay aligned
+	while(bytes % sizeof(T) != 0)
+		bytes += line;
+	stride = bytes / sizeof(T);
+
+	memory = ::operator new(3 * bytes + line);
+	return reinterpret_cast<T*>((reinterpret_cast<uintptr_t>(memory) + line - 1) / line * line);
+}
+
+template <typename T>
+ArrayTripleBuffer<T>::ArrayTripleBuffer(size_t size) : count(size){
+
+	allocate(T());
+}
+
+template <typename T>
+ArrayTripleBuffer<T>::ArrayTripleBuffer(size_t size, const T& init) : count(size){
+
+	allocate(init);
+}
+
+template <typename T>
+ArrayTripleBuffer<T>::~ArrayTripleBuffer(){
+
+	for(size_t i = 0; i < 3 * stride; ++i)
+		slots[i].~T();
+	::operator delete(memory);
+}
+
+template <typename T>
+void ArrayTripleBuffer<T>::allocate(const T& init){
+
+	slots = allocateSlots<T>(count, stride, memory);
+
+	size_t constructed(0);
+	try {
+		for(; constructed < 3 * stride; ++constructed)
+			new (slots + constructed) T(init);
+	}
+	catch(...){
+		while(constructed > 0)
+			slots[--constructed].~T();
+		::operator delete(memory);
+		throw;
+	}
+}
+
+template <typename T>
+size_t ArrayTripleBuffer<T>::size() const{
+
+	return count;
+}
+
+template <typename T>
+Span<const T> ArrayTripleBuffer<T>::snap() const{
+
+	return Span<const T>(slots + flags.snapIndex() * stride, count); // read snap index
+}
+
+template <typename T>
+Span<T> ArrayTripleBuffer<T>::dirty(){
+
+	return Span<T>(slots + flags.dirtyIndex() * stride, count); // dirty index
+}
+
+template <typename T>
+void ArrayTripleBuffer<T>::write(const T* newT){
+
+	copy(newT, newT + count, slots + flags.dirtyIndex() * stride); // write into dirty index
+}
+
+template <typename T>
+bool ArrayTripleBuffer<T>::newSnap(){
+
+	return flags.newSnap();
+}
+
+template <typename T>
+void ArrayTripleBuffer<T>::flipWriter(){
+
+	flags.flipWriter();
+}
+
+template <typename T>
+Span<const T> ArrayTripleBuffer<T>::readLast(){
+	newSnap(); // get most recent value
+	return snap(); // return it
+}
+
+template <typename T>
+void ArrayTripleBuffer<T>::update(const T* newT){
+	write(newT); // write new value
+	flipWriter(); // change dirty/clean buffer positions for the next update
+}
+
+#endif /* ARRAYTRIPLEBUFFER_HXX_ */
@@ -0,0 +1,529 @@
+//============================================================================
+// Name        : BenchTripleBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : TripleBuffer layout and latency benchmarks
+//============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "TripleBuffer.hxx"
+#include "ArrayTripleBuffer.hxx"
+#include "ColdTripleBuffer.hxx"
+#include "CompactTripleBuffer.hxx"
+#include "Crc32c.hxx"
+#include "DuplexChannel.hxx"
+#include "BenchWorkload.hxx"
+#include "ParallelWriter.hxx"
+
+using namespace std;
+
+// value wrapper giving every slot its own cache line (and the flags too, as they
+// come before the first slot), which is the padded layout
+template <typename T>
+struct alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) Padded
+{
+	T value;
+
+	Padded() : value() {}
+	Padded(const T& v) : value(v) {}
+	operator T() const { return value; }
+};
+
+struct Tiny
+{
+	uint64_t seq;
+	uint64_t data;
+};
+
+struct Wide
+{
+	uint64_t seq;
+	double bid;
+	double ask;
+	double levels[509]; // 4 KiB in all
+};
+
+// stop the optimizer from dropping the computation of value
+template <typename T>
+static void keep(const T& value){
+	__asm__ __volatile__("" : : "r"(&value) : "memory");
+}
+
+static uint64_t nowNs(){
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void printPercentiles(const char* name, vector<uint64_t>& samples){
+	if(samples.empty()){
+		printf("%-28s no samples\n", name);
+		return;
+	}
+	sort(samples.begin(), samples.end());
+	size_t n(samples.size());
+	printf("%-28s p50 %8llu ns  p99 %8llu ns  p99.9 %8llu ns  max %8llu ns\n", name,
+			(unsigned long long)samples[n / 2],
+			(unsigned long long)samples[n * 99 / 100],
+			(unsigned long long)samples[n * 999 / 1000],
+			(unsigned long long)samples[n - 1]);
+}
+
+// round trip of a value through two buffers, one per direction, which mostly
+// measures the coherence misses a reader takes to see a fresh value
+template <typename Buffer>
+static void benchPingPong(const char* name, unsigned long iterations){
+
+	Buffer ping, pong;
+	vector<uint64_t> samples;
+	samples.reserve(iterations);
+
+	thread echo([&](){
+		unsigned long spins(0);
+		for(unsigned long i = 1; i <= iterations; ++i){
+			while(!ping.newSnap())
+				TripleBufferFlags::backoff(spins);
+			Tiny t = ping.snap();
+			pong.update(t);
+		}
+	});
+
+	unsigned long spins(0);
+	for(unsigned long i = 1; i <= iterations; ++i){
+		Tiny t = { i, 0 };
+		uint64_t start(nowNs());
+		ping.update(t);
+		while(!pong.newSnap())
+			TripleBufferFlags::backoff(spins);
+		samples.push_back(nowNs() - start);
+	}
+	echo.join();
+
+	printPercentiles(name, samples);
+}
+
+// the same round trip through the two directions of one DuplexChannel, state one
+// way and commands back as in a control loop
+static void benchDuplex(const char* name, unsigned long iterations){
+
+	DuplexChannel<Tiny, Tiny> channel;
+	vector<uint64_t> samples;
+	samples.reserve(iterations);
+
+	thread echo([&](){
+		DuplexEndpoint<Tiny, Tiny>& side = channel.second();
+		unsigned long spins(0);
+		for(unsigned long i = 1; i <= iterations; ++i){
+			while(!side.newSnap())
+				TripleBufferFlags::backoff(spins);
+			side.update(side.snap());
+		}
+	});
+
+	DuplexEndpoint<Tiny, Tiny>& side = channel.first();
+	unsigned long spins(0);
+	for(unsigned long i = 1; i <= iterations; ++i){
+		Tiny t = { i, 0 };
+		uint64_t start(nowNs());
+		side.update(t);
+		while(!side.newSnap())
+			TripleBufferFlags::backoff(spins);
+		samples.push_back(nowNs() - start);
+	}
+	echo.join();
+
+	printPercentiles(name, samples);
+}
+
+// writer publishing back-to-back while the reader keeps polling, where sharing
+// the line between the writer's slot and the reader's flags costs the most
+template <typename Buffer>
+static void benchStream(const char* name, unsigned long iterations){
+
+	Buffer buffer;
+	atomic<bool> done(false);
+	unsigned long reads(0);
+
+	thread reader([&](){
+		while(!done.load(memory_order_relaxed)){
+			if(buffer.newSnap()){
+				Tiny t = buffer.snap();
+				reads += (t.seq != 0);
+			}
+			TripleBufferFlags::relax();
+		}
+	});
+
+	uint64_t start(nowNs());
+	for(unsigned long i = 1; i <= iterations; ++i){
+		Tiny t = { i, i };
+		buffer.update(t);
+	}
+	uint64_t elapsed(nowNs() - start);
+	done.store(true);
+	reader.join();
+
+	printf("%-28s %8.1f ns/update  %5.1f%% of updates read\n", name,
+			(double)elapsed / iterations, 100.0 * reads / iterations);
+}
+
+// message of the workload runs, only the first bytes of the payload are written
+struct Message
+{
+	uint64_t seq;
+	uint64_t sent;
+	uint32_t bytes;
+	unsigned char payload[4096];
+};
+
+// writer publishing on a schedule and a reader taking values with a processing
+// time model, reporting conflation, latency from publish to take, and CPU time
+static void benchWorkload(const char* name, const vector<BenchWorkload::Arrival>& arrivals, BenchWorkload::Processing processing){
+
+	if(arrivals.empty()){
+		printf("%-28s no arrivals, skipped\n", name);
+		return;
+	}
+
+	TripleBuffer<Message> buffer;
+	atomic<bool> done(false);
+	uint64_t writerCpu(0);
+
+	uint64_t start(BenchWorkload::nowNs() + 1000000); // leave the reader time to start
+	thread writer([&](){
+		uint64_t cpu(BenchWorkload::threadCpuNs());
+		for(size_t i = 0; i < arrivals.size(); ++i){
+			uint64_t due(start + arrivals[i].time);
+			for(uint64_t now; (now = BenchWorkload::nowNs()) < due; ){
+				if(due - now > 200000) // idle producer, sleep through most of long gaps
+					this_thread::sleep_for(chrono::nanoseconds(due - now - 100000));
+				else
+					TripleBufferFlags::relax();
+			}
+
+			Message& message = buffer.dirty();
+			message.seq = i + 1;
+			message.bytes = min<uint32_t>(arrivals[i].bytes, sizeof(message.payload));
+			memset(message.payload, static_cast<int>(i), message.bytes);
+			message.sent = BenchWorkload::nowNs();
+			buffer.flipWriter();
+		}
+		writerCpu = BenchWorkload::threadCpuNs() - cpu;
+		done.store(true);
+	});
+
+	vector<uint64_t> latencies;
+	latencies.reserve(arrivals.size());
+	uint64_t taken(0), cpu(BenchWorkload::threadCpuNs());
+	unsigned long spins(0);
+	while(!done.load(memory_order_relaxed) || buffer.lastConsumed() != arrivals.size()){
+		if(!buffer.newSnap()){
+			TripleBufferFlags::backoff(spins);
+			continue;
+		}
+		latencies.push_back(BenchWorkload::nowNs() - buffer.snapRef().sent);
+		++taken;
+		BenchWorkload::Processing::spin(processing.next());
+	}
+	uint64_t readerCpu(BenchWorkload::threadCpuNs() - cpu);
+	uint64_t wall(BenchWorkload::nowNs() - start);
+	writer.join();
+
+	printPercentiles(name, latencies);
+	printf("%-28s %5.1f%% conflated, CPU writer %5.1f%% reader %5.1f%% of %.0f ms\n", "",
+			100.0 * (arrivals.size() - taken) / arrivals.size(),
+			100.0 * writerCpu / wall, 100.0 * readerCpu / wall, wall / 1e6);
+}
+
+// reader cost of taking the latest wide snapshot whole or only the members it
+// needs, while the writer keeps publishing
+template <typename Read>
+static void benchProjection(const char* name, Read read, unsigned long iterations){
+
+	TripleBuffer<Wide> buffer;
+	atomic<bool> done(false);
+
+	thread writer([&](){
+		Wide w = Wide();
+		while(!done.load(memory_order_relaxed)){
+			++w.seq;
+			w.bid = w.seq;
+			w.ask = w.seq + 1;
+			buffer.update(w);
+		}
+	});
+
+	double sink(0);
+	uint64_t start(nowNs());
+	for(unsigned long i = 0; i < iterations; ++i)
+		sink += read(buffer);
+	uint64_t elapsed(nowNs() - start);
+	done.store(true);
+	writer.join();
+
+	keep(sink);
+
+	printf("%-28s %8.1f ns/read\n", name, (double)elapsed / iterations);
+}
+
+// throughput of the slot stamps, as a reader verifying every snap would see it
+static void benchCrc(const char* name, uint32_t (*crc)(const void*, size_t, uint32_t), unsigned long iterations){
+
+	vector<unsigned char> slot(1 << 20);
+	for(size_t i = 0; i < slot.size(); ++i)
+		slot[i] = static_cast<unsigned char>(i * 7);
+
+	unsigned long rounds(max(1UL, iterations / 1000));
+	uint32_t sink(0);
+	uint64_t start(nowNs());
+	for(unsigned long i = 0; i < rounds; ++i)
+		sink += crc(slot.data(), slot.size(), i);
+	uint64_t elapsed(nowNs() - start);
+
+	printf("%-28s %8.2f GB/s  (%08x)\n", name, (double)slot.size() * rounds / elapsed, sink);
+}
+
+// large, mostly empty value, as kept by an order book or a lookup table
+struct Sparse
+{
+	uint64_t seq;
+	double values[1 << 21]; // 16 MiB, one in 64 set
+};
+
+static Sparse& fill(Sparse& value, uint64_t seq){
+
+	value.seq = seq;
+	for(size_t i = 0; i < (1 << 21); i += 64)
+		value.values[i] = seq + i;
+	return value;
+}
+
+static double residentMiB(){
+
+	FILE* statm(fopen("/proc/self/statm", "r"));
+	unsigned long size(0), resident(0);
+	if(statm){
+		if(fscanf(statm, "%lu %lu", &size, &resident) != 2)
+			resident = 0;
+		fclose(statm);
+	}
+	return resident * (double)sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+// memory given back by packing the cold slots of an idle channel, and what the
+// writer pays on its first update after that
+static void benchCold(unsigned long rounds){
+
+	Sparse* value(new Sparse());
+	ColdTripleBuffer<Sparse> buffer(chrono::nanoseconds(0));
+	for(uint64_t seq = 1; seq <= 3; ++seq)
+		buffer.update(fill(*value, seq));
+	keep(buffer.readLast());
+
+	double before(residentMiB());
+	uint64_t start(nowNs());
+	size_t released(buffer.compact());
+	uint64_t pass(nowNs() - start);
+	printf("%-28s %8.1f MiB -> %.1f MiB resident (buffer %.1f MiB -> %.1f MiB), pass %.2f ms\n", "compact()",
+			before, residentMiB(), (buffer.residentBytes() + released) / 1048576.0, buffer.residentBytes() / 1048576.0, pass / 1e6);
+
+	vector<uint64_t> warmDirty, coldDirty, warmWrite, coldWrite;
+	for(unsigned long i = 0; i < rounds; ++i){
+		for(int cold = 0; cold < 2; ++cold){
+			if(cold){
+				buffer.readLast();
+				buffer.compact();
+			}
+			else
+				while(buffer.coldSlots()){ // unpack what the previous round left packed
+					buffer.dirty();
+					buffer.flipWriter();
+				}
+			start = nowNs();
+			buffer.dirty().seq = i;
+			buffer.flipWriter();
+			(cold ? coldDirty : warmDirty).push_back(nowNs() - start);
+
+			if(cold){
+				buffer.readLast();
+				buffer.compact();
+			}
+			else
+				while(buffer.coldSlots()){
+					buffer.dirty();
+					buffer.flipWriter();
+				}
+			fill(*value, i);
+			start = nowNs();
+			buffer.update(*value);
+			(cold ? coldWrite : warmWrite).push_back(nowNs() - start);
+		}
+	}
+	delete value;
+
+	printPercentiles("dirty() + flip, warm", warmDirty);
+	printPercentiles("dirty() + flip, packed", coldDirty);
+	printPercentiles("update(), warm", warmWrite);
+	printPercentiles("update(), packed", coldWrite);
+}
+
+// time to fill and publish a large slot when a team of workers shares the fill,
+// taken by worker 0 from the start of its part to the return of publish()
+static void benchParallel(unsigned workers, size_t size, unsigned long rounds){
+
+	ArrayTripleBuffer<double> buffer(size);
+	ParallelWriter<ArrayTripleBuffer<double> > team(buffer, workers);
+	vector<uint64_t> samples;
+	samples.reserve(rounds);
+
+	vector<thread> threads;
+	for(unsigned w = 0; w < workers; ++w)
+		threads.push_back(thread([&, w](){
+			size_t begin, end;
+			ParallelWriter<ArrayTripleBuffer<double> >::chunk(size, w, workers, begin, end);
+			for(unsigned long i = 0; i < rounds; ++i){
+				uint64_t start(nowNs());
+				Span<double> slot(team.dirty());
+				for(size_t j = begin; j < end; ++j)
+					slot[j] = i + j * 0.5;
+				team.publish();
+				if(w == 0)
+					samples.push_back(nowNs() - start);
+			}
+		}));
+	for(thread& t : threads)
+		t.join();
+	keep(buffer.readLast()[size - 1]);
+
+	char name[32];
+	snprintf(name, sizeof(name), "%u worker%s", workers, workers == 1 ? "" : "s");
+	printPercentiles(name, samples);
+}
+
+static bool selected(int argc, char** argv, const char* bench){
+	if(argc < 2)
+		return true;
+	for(int i = 1; i < argc; ++i)
+		if(strcmp(argv[i], bench) == 0)
+			return true;
+	return false;
+}
+
+int main(int argc, char** argv) {
+
+	unsigned long iterations(getenv("BENCH_ITERATIONS") ? strtoul(getenv("BENCH_ITERATIONS"), 0, 10) : 1000000);
+
+	if(selected(argc, argv, "layout")){
+		printf("== ping-pong round trip (%lu iterations)\n", iterations);
+		benchPingPong<TripleBuffer<Tiny> >("TripleBuffer", iterations);
+		benchPingPong<TripleBuffer<Padded<Tiny> > >("TripleBuffer (padded)", iterations);
+		benchPingPong<CompactTripleBuffer<Tiny> >("CompactTripleBuffer", iterations);
+
+		printf("== streaming updates with a polling reader (%lu iterations)\n", iterations);
+		benchStream<TripleBuffer<Tiny> >("TripleBuffer", iterations);
+		benchStream<TripleBuffer<Padded<Tiny> > >("TripleBuffer (padded)", iterations);
+		benchStream<CompactTripleBuffer<Tiny> >("CompactTripleBuffer", iterations);
+	}
+
+	if(selected(argc, argv, "duplex")){
+		printf("== control loop round trip (%lu iterations)\n", iterations);
+		benchPingPong<TripleBuffer<Tiny> >("two TripleBuffers", iterations);
+		benchDuplex("DuplexChannel", iterations);
+	}
+
+	if(selected(argc, argv, "workload")){
+		size_t count(iterations / 10);
+		double rate(getenv("BENCH_RATE") ? strtod(getenv("BENCH_RATE"), 0) : 100000);
+		printf("== workloads (%zu values at %.0f/s, latency in ns from publish to take)\n", count, rate);
+
+		vector<BenchWorkload::Arrival> steady(BenchWorkload::uniform(count, rate));
+		BenchWorkload::PayloadSizes::fixed(64).apply(steady);
+		benchWorkload("uniform, 64 B", steady, BenchWorkload::Processing::none());
+
+		vector<BenchWorkload::Arrival> random(BenchWorkload::poisson(count, rate));
+		BenchWorkload::PayloadSizes::lognormal(256, 1, 4096).apply(random);
+		benchWorkload("poisson, lognormal sizes", random, BenchWorkload::Processing::exponential(static_cast<uint64_t>(0.5e9 / rate)));
+
+		vector<BenchWorkload::Arrival> bursts(BenchWorkload::bursty(count, 100, 200, static_cast<uint64_t>(100e9 / rate)));
+		BenchWorkload::PayloadSizes::bimodal(64, 4096, 0.1).apply(bursts);
+		benchWorkload("bursty, bimodal sizes", bursts, BenchWorkload::Processing::fixed(2000));
+
+		if(getenv("BENCH_TRACE"))
+			benchWorkload("trace", BenchWorkload::trace(getenv("BENCH_TRACE")), BenchWorkload::Processing::none());
+	}
+
+	if(selected(argc, argv, "projection")){
+		printf("== reading 2 members of a 4 KiB snapshot (%lu iterations)\n", iterations);
+		benchProjection("readLast()", [](TripleBuffer<Wide>& b){ Wide w = b.readLast(); keep(w); return w.ask - w.bid; }, iterations);
+		benchProjection("readLast(&bid, &ask)", [](TripleBuffer<Wide>& b){
+			tuple<double, double> quote(b.readLast(&Wide::bid, &Wide::ask));
+			return get<1>(quote) - get<0>(quote);
+		}, iterations);
+		benchProjection("visitLast", [](TripleBuffer<Wide>& b){
+			return b.visitLast([](const Wide& w){ return w.ask - w.bid; });
+		}, iterations);
+	}
+
+	if(selected(argc, argv, "crc32c")){
+		printf("== CRC32C of a 1 MiB slot (%s)\n", Crc32c::hardware() ? "crc instructions available" : "no crc instructions");
+		benchCrc("Crc32c::compute", Crc32c::compute, iterations);
+		benchCrc("Crc32c::portable", Crc32c::portable, iterations);
+	}
+
+	if(selected(argc, argv, "cold")){
+#ifdef TRIPLEBUFFER_HAVE_LZ4
+		const char* codec("LZ4");
+#else
+		const char* codec("WordRunCodec");
+#endif
+		unsigned long rounds(max(5UL, iterations / 100000));
+		printf("== cold slots of a 16 MiB value (%s, wake-up latency over %lu rounds)\n", codec, rounds);
+		benchCold(rounds);
+	}
+
+	if(selected(argc, argv, "parallel")){
+		unsigned most(getenv("BENCH_WORKERS") ? strtoul(getenv("BENCH_WORKERS"), 0, 10) : thread::hardware_concurrency());
+		most = max(1U, most);
+		size_t size(1 << 22);
+		unsigned long rounds(max(5UL, iterations / 20000));
+		printf("== ParallelWriter fill + publish of a 32 MiB slot (%lu rounds, up to %u workers)\n", rounds, most);
+		for(unsigned workers = 1; workers < most; workers *= 2)
+			benchParallel(workers, size, rounds);
+		benchParallel(most, size, rounds);
+	}
+
+	return 0;
+}
@@ -0,0 +1,311 @@
+//============================================================================
+// Name        : BenchWorkload.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Arrival, payload size and reader processing models for the benchmarks
+//============================================================================
+
+#ifndef BENCHWORKLOAD_HXX_
+#define BENCHWORKLOAD_HXX_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+using namespace std;
+
+// Traffic models for the benchmarks: when values arrive, how large they are and
+// how long the reader takes with each one. Schedules are generated up front so
+// the generators cost nothing while measuring.
+class BenchWorkload
+{
+
+public:
+
+	struct Arrival
+	{
+		uint64_t time; // nanoseconds since the start of the run
+		uint32_t bytes; // payload size
+	};
+
+	// arrival patterns, times only, sizes are filled by a PayloadSizes
+	static vector<Arrival> uniform(size_t count, double rate); // back-to-back at a steady rate per second
+	static vector<Arrival> poisson(size_t count, double rate, uint64_t seed = 1); // exponential gaps with mean 1 / rate
+	static vector<Arrival> bursty(size_t count, size_t burst, uint64_t gap, uint64_t pause); // bursts of values gap ns apart, pause ns between bursts
+	static vector<Arrival> trace(const char* path); // recorded arrivals sorted by time, relative to the earliest one
+	static void writeTrace(const char* path, const vector<Arrival>& arrivals); // binary: uint64_t time, uint32_t bytes per arrival, native endianness, in any order
+
+	// payload size distributions
+	class PayloadSizes
+	{
+
+	public:
+
+		static PayloadSizes fixed(uint32_t bytes);
+		static PayloadSizes uniform(uint32_t least, uint32_t most);
+		static PayloadSizes lognormal(uint32_t median, double sigma, uint32_t most); // heavy tailed, clamped to most
+		static PayloadSizes bimodal(uint32_t small, uint32_t large, double largeShare); // mostly small, sometimes large
+
+		void apply(vector<Arrival>& arrivals, uint64_t seed = 2) const; // set the size of every arrival
+
+	private:
+
+		enum Kind { Fixed, Uniform, Lognormal, Bimodal };
+
+		PayloadSizes(Kind kind, uint32_t a, uint32_t b, double shape);
+
+		Kind kind;
+		uint32_t a, b;
+		double shape;
+	};
+
+	// time the reader spends with each value it takes
+	class Processing
+	{
+
+	public:
+
+		static Processing none();
+		static Processing fixed(uint64_t ns);
+		static Processing exponential(uint64_t meanNs, uint64_t seed = 3);
+
+		uint64_t next(); // processing time of the next value
+		static void spin(uint64_t ns); // busy for ns, as real work would be
+
+	private:
+
+		Processing(uint64_t mean, bool random, uint64_t seed);
+
+		uint64_t mean;
+		bool random;
+		mt19937_64 engine;
+	};
+
+	static uint64_t nowNs(); // steady clock
+	static uint64_t threadCpuNs(); // CPU time of the calling thread
+};
+
+inline vector<BenchWorkload::Arrival> BenchWorkload::uniform(size_t count, double rate){
+
+	if(!(rate > 0))
+		throw invalid_argument("BenchWorkload: uniform arrivals need a rate above 0");
+
+	vector<Arrival> arrivals(count);
+	for(size_t i = 0; i < count; ++i){
+		arrivals[i].time = static_cast<uint64_t>(i * 1e9 / rate);
+		arrivals[i].bytes = 0;
+	}
+	return arrivals;
+}
+
+inline vector<BenchWorkload::Arrival> BenchWorkload::poisson(size_t count, double rate, uint64_t seed){
+
+	if(!(rate > 0))
+		throw invalid_argument("BenchWorkload: poisson arrivals need a rate above 0");
+
+	mt19937_64 engine(seed);
+	exponential_distribution<double> gaps(rate / 1e9);
+
+	vector<Arrival> arrivals(count);
+	double time(0);
+	for(size_t i = 0; i < count; ++i){
+		time += gaps(engine);
+		arrivals[i].time = static_cast<uint64_t>(time);
+		arrivals[i].bytes = 0;
+	}
+	return arrivals;
+}
+
+inline vector<BenchWorkload::Arrival> BenchWorkload::bursty(size_t count, size_t burst, uint64_t gap, uint64_t pause){
+
+	if(burst == 0)
+		throw invalid_argument("BenchWorkload: bursty arrivals need bursts of at least 1 value");
+
+	vector<Arrival> arrivals(count);
+	uint64_t time(0);
+	for(size_t i = 0; i < count; ++i){
+		if(i != 0)
+			time += (i % burst == 0) ? pause : gap;
+		arrivals[i].time = time;
+		arrivals[i].bytes = 0;
+	}
+	return arrivals;
+}
+
+inline vector<BenchWorkload::Arrival> BenchWorkload::trace(const char* path){
+
+	FILE* file(fopen(path, "rb"));
+	if(!file)
+		throw runtime_error(string("BenchWorkload: cannot open trace ") + path);
+
+	vector<Arrival> arrivals;
+	Arrival arrival;
+	while(fread(&arrival.time, sizeof(arrival.time), 1, file) == 1 &&
+	      fread(&arrival.bytes, sizeof(arrival.bytes), 1, file) == 1)
+		arrivals.push_back(arrival);
+	fclose(file);
+
+	// captures may be out of order, replay them by time, relative to the earliest arrival
+	stable_sort(arrivals.begin(), arrivals.end(), [](const Arrival& a, const Arrival& b){ return a.time < b.time; });
+	for(size_t i = arrivals.size(); i-- > 0; )
+		arrivals[i].time -= arrivals[0].time;
+	return arrivals;
+}
+
+inline void BenchWorkload::writeTrace(const char* path, const vector<Arrival>& arrivals){
+
+	FILE* file(fopen(path, "wb"));
+	if(!file)
+		throw runtime_error(string("BenchWorkload: cannot create trace ") + path);
+
+	for(size_t i = 0; i < arrivals.size(); ++i){
+		fwrite(&arrivals[i].time, sizeof(arrivals[i].time), 1, file);
+		fwrite(&arrivals[i].bytes, sizeof(arrivals[i].bytes), 1, file);
+	}
+	if(fclose(file) != 0)
+		throw runtime_error(string("BenchWorkload: cannot write trace ") + path);
+}
+
+inline BenchWorkload::PayloadSizes::PayloadSizes(Kind kind, uint32_t a, uint32_t b, double shape) :
+		kind(kind), a(a), b(b), shape(shape){
+}
+
+inline BenchWorkload::PayloadSizes BenchWorkload::PayloadSizes::fixed(uint32_t bytes){
+
+	return PayloadSizes(Fixed, bytes, bytes, 0);
+}
+
+inline BenchWorkload::PayloadSizes BenchWorkload::PayloadSizes::uniform(uint32_t least, uint32_t most){
+
+	if(least > most)
+		throw invalid_argument("BenchWorkload: uniform sizes need least <= most");
+	return PayloadSizes(Uniform, least, most, 0);
+}
+
+inline BenchWorkload::PayloadSizes BenchWorkload::PayloadSizes::lognormal(uint32_t median, double sigma, uint32_t most){
+
+	if(median == 0 || !(sigma > 0))
+		throw invalid_argument("BenchWorkload: lognormal sizes need a median and a sigma above 0");
+	return PayloadSizes(Lognormal, median, most, sigma);
+}
+
+inline BenchWorkload::PayloadSizes BenchWorkload::PayloadSizes::bimodal(uint32_t small, uint32_t large, double largeShare){
+
+	if(!(largeShare >= 0 && largeShare <= 1))
+		throw invalid_argument("BenchWorkload: bimodal sizes need a share of large values in [0, 1]");
+	return PayloadSizes(Bimodal, small, large, largeShare);
+}
+
+inline void BenchWorkload::PayloadSizes::apply(vector<Arrival>& arrivals, uint64_t seed) const{
+
+	// only the distribution of this kind, the parameters of the others may not fit theirs
+	mt19937_64 engine(seed);
+	switch(kind){
+	case Fixed:
+		for(size_t i = 0; i < arrivals.size(); ++i)
+			arrivals[i].bytes = a;
+		break;
+	case Uniform: {
+		uniform_int_distribution<uint32_t> between(a, b);
+		for(size_t i = 0; i < arrivals.size(); ++i)
+			arrivals[i].bytes = between(engine);
+		break;
+	}
+	case Lognormal: {
+		lognormal_distribution<double> tail(log(static_cast<double>(a)), shape);
+		for(size_t i = 0; i < arrivals.size(); ++i){
+			double bytes(tail(engine));
+			arrivals[i].bytes = bytes < b ? static_cast<uint32_t>(bytes) : b;
+		}
+		break;
+	}
+	case Bimodal: {
+		bernoulli_distribution large(shape);
+		for(size_t i = 0; i < arrivals.size(); ++i)
+			arrivals[i].bytes = large(engine) ? b : a;
+		break;
+	}
+	}
+}
+
+inline BenchWorkload::Processing::Processing(uint64_t mean, bool random, uint64_t seed) :
+		mean(mean), random(random), engine(seed){
+}
+
+inline BenchWorkload::Processing BenchWorkload::Processing::none(){
+
+	return Processing(0, false, 0);
+}
+
+inline BenchWorkload::Processing BenchWorkload::Processing::fixed(uint64_t ns){
+
+	return Processing(ns, false, 0);
+}
+
+inline BenchWorkload::Processing BenchWorkload::Processing::exponential(uint64_t meanNs, uint64_t seed){
+
+	return Processing(meanNs, true, seed);
+}
+
+inline uint64_t BenchWorkload::Processing::next(){
+
+	if(!random || mean == 0)
+		return mean;
+	exponential_distribution<double> time(1.0 / mean);
+	return static_cast<uint64_t>(time(engine));
+}
+
+inline void BenchWorkload::Processing::spin(uint64_t ns){
+
+	if(ns == 0)
+		return;
+	uint64_t end(nowNs() + ns);
+	while(nowNs() < end)
+		;
+}
+
+inline uint64_t BenchWorkload::nowNs(){
+
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t BenchWorkload::threadCpuNs(){
+
+	timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + time.tv_nsec;
+}
+
+#endif /* BENCHWORKLOAD_HXX_ */
@@ -0,0 +1,250 @@
+//============================================================================
+// Name        : ChunkedTripleBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Triple buffer of large arrays readable chunk by chunk while being written
+//============================================================================
+
+#ifndef CHUNKEDTRIPLEBUFFER_HXX_
+#define CHUNKEDTRIPLEBUFFER_HXX_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+#include "ArrayTripleBuffer.hxx"
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+// Triple buffer of a large runtime sized array published chunk by chunk. Every
+// chunk of a slot is stamped with the sequence number of the version it belongs
+// to once the writer is done with it, so a reader can copy out the completed
+// chunks of the version still being written (readChunk) while keeping the usual
+// fully consistent snap of the last published version (newSnap / snap).
+//
+// The writer must write every chunk of every version, since the dirty slot holds
+// the data of two versions ago. Chunk indexes past chunks() throw out_of_range.
+template <typename T>
+class ChunkedTripleBuffer
+{
+
+public:
+
+	ChunkedTripleBuffer<T>(size_t size, size_t chunkSize);
+	~ChunkedTripleBuffer<T>();
+
+	// non-copyable behavior
+	ChunkedTripleBuffer<T>(const ChunkedTripleBuffer<T>&) = delete;
+	ChunkedTripleBuffer<T>& operator=(const ChunkedTripleBuffer<T>&) = delete;
+
+	size_t size() const; // number of elements in each slot
+	size_t chunks() const; // number of chunks in each slot
+
+	// writer side
+	Span<T> beginChunk(size_t chunk); // get a chunk of the dirty slot to write into
+	void endChunk(size_t chunk); // mark the chunk complete for the version being written
+	void flipWriter(); // publish the version being written, once all its chunks are complete
+	void update(const T* newT); // wrapper writing all the chunks of a new version (begin/endChunk + flipWriter)
+
+	// reader side, fully consistent versions
+	Span<const T> snap() const; // get the current snap to read
+	uint64_t snapSeq() const; // sequence number of the current snap, 0 before the first one
+	bool newSnap(); // swap to the latest version, if any
+
+	// reader side, progressive reads of the version being written
+	uint64_t inFlightSeq() const; // sequence number of the version the writer is working on
+	bool readChunk(uint64_t seq, size_t chunk, T* out) const; // copy a completed chunk of version seq, false if not available
+
+private:
+
+	Span<const T> chunkRange(size_t chunk, const T* slot) const; // chunk of a slot, the last one may be shorter
+
+	TripleBufferFlags flags; // dirty / clean / snap indexes
+
+	size_t count; // elements per slot
+	size_t chunkSize; // elements per chunk
+	size_t chunkCount; // chunks per slot
+	size_t stride; // elements between the start of two slots, a whole number of cache lines
+	void* memory; // allocation holding the three slots
+	T* slots; // first slot, aligned to a cache line
+
+	uint64_t seq[3]; // sequence number of the version held by each slot, set by flipWriter
+	unique_ptr<atomic<uint64_t>[]> chunkSeq; // per slot and chunk, version of its contents, 0 while being written
+
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<uint64_t> writing; // version the writer is working on
+};
+
+// include implementation in header since it is a template
+
+template <typename T>
+ChunkedTripleBuffer<T>::ChunkedTripleBuffer(size_t size, size_t chunkSize) :
+		count(size), chunkSize(chunkSize), chunkCount(chunkSize ? (size + chunkSize - 1) / chunkSize : 0){
+
+	static_assert(is_trivially_copyable<T>::value, "chunks are copied while the writer may reuse them");
+
+	if(chunkSize == 0)
+		throw invalid_argument("ChunkedTripleBuffer chunk size must be positive");
+
+	chunkSeq.reset(new atomic<uint64_t>[3 * chunkCount]);
+	slots = allocateSlots<T>(count, stride, memory);
+	memset(static_cast<void*>(slots), 0, 3 * stride * sizeof(T));
+
+	for(int i = 0; i < 3; ++i)
+		seq[i] = 0;
+	for(size_t i = 0; i < 3 * chunkCount; ++i)
+		chunkSeq[i].store(0, std::memory_order_relaxed);
+
+	writing.store(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+ChunkedTripleBuffer<T>::~ChunkedTripleBuffer(){
+
+	::operator delete(memory);
+}
+
+template <typename T>
+size_t ChunkedTripleBuffer<T>::size() const{
+
+	return count;
+}
+
+template <typename T>
+size_t ChunkedTripleBuffer<T>::chunks() const{
+
+	return chunkCount;
+}
+
+template <typename T>
+Span<const T> ChunkedTripleBuffer<T>::chunkRange(size_t chunk, const T* slot) const{
+
+	size_t begin(chunk * chunkSize);
+	return Span<const T>(slot + begin, min(chunkSize, count - begin));
+}
+
+template <typename T>
+Span<T> ChunkedTripleBuffer<T>::beginChunk(size_t chunk){
+
+	if(chunk >= chunkCount)
+		throw out_of_range("ChunkedTripleBuffer chunk index");
+	uint_fast8_t dirty(flags.dirtyIndex());
+
+	// invalidate the chunk before touching its data, so progressive readers drop their copy
+	chunkSeq[dirty * chunkCount + chunk].store(0, std::memory_order_relaxed);
+	atomic_thread_fence(std::memory_order_release);
+
+	size_t begin(chunk * chunkSize);
+	return Span<T>(slots + dirty * stride + begin, min(chunkSize, count - begin));
+}
+
+template <typename T>
+void ChunkedTripleBuffer<T>::endChunk(size_t chunk){
+
+	if(chunk >= chunkCount)
+		throw out_of_range("ChunkedTripleBuffer chunk index");
+	uint_fast8_t dirty(flags.dirtyIndex());
+	chunkSeq[dirty * chunkCount + chunk].store(writing.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+template <typename T>
+void ChunkedTripleBuffer<T>::flipWriter(){
+
+	uint64_t version(writing.load(std::memory_order_relaxed));
+
+	seq[flags.dirtyIndex()] = version; // published along with the slot by the flip
+	flags.flipWriter();
+	writing.store(version + 1, std::memory_order_release);
+}
+
+template <typename T>
+void ChunkedTripleBuffer<T>::update(const T* newT){
+
+	for(size_t chunk = 0; chunk < chunkCount; ++chunk){
+		Span<T> part(beginChunk(chunk));
+		copy(newT + chunk * chunkSize, newT + chunk * chunkSize + part.size(), part.begin());
+		endChunk(chunk);
+	}
+	flipWriter();
+}
+
+template <typename T>
+Span<const T> ChunkedTripleBuffer<T>::snap() const{
+
+	return Span<const T>(slots + flags.snapIndex() * stride, count); // read snap index
+}
+
+template <typename T>
+uint64_t ChunkedTripleBuffer<T>::snapSeq() const{
+
+	return seq[flags.snapIndex()];
+}
+
+template <typename T>
+bool ChunkedTripleBuffer<T>::newSnap(){
+
+	return flags.newSnap();
+}
+
+template <typename T>
+uint64_t ChunkedTripleBuffer<T>::inFlightSeq() const{
+
+	return writing.load(std::memory_order_acquire);
+}
+
+template <typename T>
+bool ChunkedTripleBuffer<T>::readChunk(uint64_t version, size_t chunk, T* out) const{
+
+	if(chunk >= chunkCount)
+		throw out_of_range("ChunkedTripleBuffer chunk index");
+	if(version == 0) // stamp of the chunks being written
+		return false;
+
+	// the version may still be dirty or already published, look for it in every slot
+	for(int slot = 0; slot < 3; ++slot){
+		const atomic<uint64_t>& stamp(chunkSeq[slot * chunkCount + chunk]);
+		if(stamp.load(std::memory_order_acquire) != version)
+			continue;
+
+		Span<const T> part(chunkRange(chunk, slots + slot * stride));
+		memcpy(static_cast<void*>(out), part.data(), part.size() * sizeof(T));
+
+		// the writer may have started reusing the slot while we copied, validate like a seqlock
+		atomic_thread_fence(std::memory_order_acquire);
+		if(stamp.load(std::memory_order_relaxed) == version)
+			return true;
+	}
+
+	return false;
+}
+
+#endif /* CHUNKEDTRIPLEBUFFER_HXX_ */
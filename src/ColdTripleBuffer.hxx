@@ -0,0 +1,546 @@
+//============================================================================
+// Name        : ColdTripleBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Triple buffer packing the slots of an idle channel that nobody needs
+//============================================================================
+
+#ifndef COLDTRIPLEBUFFER_HXX_
+#define COLDTRIPLEBUFFER_HXX_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef TRIPLEBUFFER_HAVE_LZ4
+#include <climits>
+#include <lz4.h>
+#endif
+
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+// Built-in codec for cold slots: runs of a repeated 8 byte word (zeroed arrays,
+// padding, unused capacity) become one word and a count, everything else is
+// copied as it is. It is cheap both ways and needs no library.
+class WordRunCodec
+{
+
+public:
+
+	bool compress(const unsigned char* data, size_t size, vector<unsigned char>& out); // replaces out, false if data cannot be packed
+	bool decompress(const unsigned char* data, size_t size, unsigned char* out, size_t outSize); // false if data is not a packed value of outSize bytes
+
+private:
+
+	// a control word (count << 1 | run) precedes each run word or literal words
+	static const uint32_t MaxCount = 0x7fffffff;
+
+	static uint64_t word(const unsigned char* data, size_t index);
+	static void put(vector<unsigned char>& out, const void* data, size_t size);
+};
+
+#ifdef TRIPLEBUFFER_HAVE_LZ4
+// LZ4 block codec, for builds linking liblz4
+class Lz4Codec
+{
+
+public:
+
+	bool compress(const unsigned char* data, size_t size, vector<unsigned char>& out);
+	bool decompress(const unsigned char* data, size_t size, unsigned char* out, size_t outSize);
+};
+
+typedef Lz4Codec ColdCodec;
+#else
+typedef WordRunCodec ColdCodec;
+#endif
+
+// Triple buffer for large T that packs the slots nobody needs while the channel
+// is idle. A housekeeping thread calls compact() now and then, or the buffer
+// runs its own with startCompactor(): once nothing was published for the idle
+// time it compresses the dirty slot, and the clean slot
+// when it holds no unread value, with Codec and gives their pages back to the
+// system. The snap and the latest value always stay as they are, so the reader
+// never waits nor pays for anything. The writer unpacks the dirty slot the first
+// time it touches it again, dirty() and flipWriter() restore its old contents
+// while write() only drops the packed copy, as it overwrites the whole slot.
+//
+// Slots are page aligned in an anonymous mapping. The writer and compact()
+// exclude each other with a spin lock, that the writer takes in dirty() or
+// write() and gives back in flipWriter(), so an update costs one more atomic
+// exchange than with TripleBuffer, and a writer waking up during a pass waits
+// for it to end. compact() skips its pass while the writer holds the lock.
+//
+// T must be trivially copyable. Codec must provide
+//     bool compress(const unsigned char* data, size_t size, vector<unsigned char>& out); // false to leave the slot as it is
+//     bool decompress(const unsigned char* data, size_t size, unsigned char* out, size_t outSize);
+// ColdCodec is LZ4 when TRIPLEBUFFER_HAVE_LZ4 is defined and WordRunCodec otherwise.
+template <typename T, typename Codec = ColdCodec>
+class ColdTripleBuffer
+{
+
+public:
+
+	explicit ColdTripleBuffer<T, Codec>(chrono::nanoseconds idle = chrono::seconds(1), const Codec& codec = Codec());
+	~ColdTripleBuffer<T, Codec>();
+
+	// non-copyable behavior
+	ColdTripleBuffer<T, Codec>(const ColdTripleBuffer<T, Codec>&) = delete;
+	ColdTripleBuffer<T, Codec>& operator=(const ColdTripleBuffer<T, Codec>&) = delete;
+
+	const T& snap() const; // get the current snap to read
+	void write(const T& newT); // write a new value
+	T& dirty(); // get the dirty slot to write into in place, unpacked if needed
+	bool newSnap(); // swap to the latest value, if any
+	void flipWriter(); // flip writer positions dirty / clean
+
+	const T& readLast(); // wrapper to read the last available element (newSnap + snap)
+	void update(const T& newT); // wrapper to update with a new element (write + flipWriter)
+
+	size_t compact(); // housekeeping: pack the cold slots once idle, returns the bytes given back
+	void startCompactor(chrono::nanoseconds period); // call compact() every period on a thread of the buffer, instead of doing it yourself
+	void stopCompactor(); // stop that thread, also done on destruction
+	unsigned coldSlots() const; // slots currently packed
+	size_t residentBytes() const; // slot pages in use plus packed copies
+	uint64_t thaws() const; // slots the writer had to unpack so far
+
+private:
+
+	static size_t pageSize();
+	T* slot(uint_fast8_t index) const;
+	void lock(); // writer: wait for a pass to end
+	bool tryLock(); // compactor
+	void unlock();
+	T& own(bool restore); // writer: take the lock if not held yet and unpack the dirty slot, or only drop its packed copy
+	void thaw(uint_fast8_t index, bool restore); // writer, locked: unpack a slot or only drop its packed copy
+	size_t freeze(uint_fast8_t index); // compactor, locked: pack a slot, returns the bytes given back
+
+	TripleBufferFlags flags;
+	size_t slotBytes; // one slot rounded to a page
+	unsigned char* region;
+	Codec codec;
+
+	atomic<bool> busy; // the writer or compact() owns the cold slots
+	atomic<uint8_t> cold; // bit per packed slot, changed under the lock
+	atomic<size_t> packedBytes;
+	vector<unsigned char> packed[3]; // packed copy of each cold slot
+
+	// writer only
+	bool writing; // holds the lock between dirty() / write() and flipWriter()
+	atomic<uint64_t> published; // flips so far, sampled by compact()
+	atomic<uint64_t> thawCount;
+
+	// compact() only
+	chrono::nanoseconds idle;
+	uint64_t lastPublished; // published at the previous pass
+	chrono::steady_clock::time_point quietSince; // when published last changed
+	vector<unsigned char> scratch;
+
+	// startCompactor() thread
+	thread compactor;
+	mutex compactorMutex;
+	condition_variable compactorWake;
+	bool stopping;
+};
+
+// include implementation in header since it is a template
+
+inline uint64_t WordRunCodec::word(const unsigned char* data, size_t index){
+
+	uint64_t value;
+	memcpy(&value, data + index * 8, 8);
+	return value;
+}
+
+inline void WordRunCodec::put(vector<unsigned char>& out, const void* data, size_t size){
+
+	const unsigned char* bytes(static_cast<const unsigned char*>(data));
+	out.insert(out.end(), bytes, bytes + size);
+}
+
+inline bool WordRunCodec::compress(const unsigned char* data, size_t size, vector<unsigned char>& out){
+
+	out.clear();
+	size_t words(size / 8);
+	size_t i(0);
+	while(i < words){
+		uint64_t value(word(data, i));
+		size_t end(i + 1);
+		while(end < words && end - i < MaxCount && word(data, end) == value)
+			++end;
+
+		if(end - i >= 2){
+			uint32_t control(static_cast<uint32_t>(end - i) << 1 | 1);
+			put(out, &control, sizeof(control));
+			put(out, &value, sizeof(value));
+			i = end;
+			continue;
+		}
+
+		// literal words up to the next run of two or more
+		size_t start(i++);
+		while(i < words && i - start < MaxCount && !(i + 1 < words && word(data, i) == word(data, i + 1)))
+			++i;
+		uint32_t control(static_cast<uint32_t>(i - start) << 1);
+		put(out, &control, sizeof(control));
+		put(out, data + start * 8, (i - start) * 8);
+	}
+	put(out, data + words * 8, size % 8);
+
+	return true;
+}
+
+inline bool WordRunCodec::decompress(const unsigned char* data, size_t size, unsigned char* out, size_t outSize){
+
+	const unsigned char* end(data + size);
+	size_t words(outSize / 8);
+	size_t i(0);
+	while(i < words){
+		uint32_t control;
+		if(end - data < static_cast<ptrdiff_t>(sizeof(control)))
+			return false;
+		memcpy(&control, data, sizeof(control));
+		data += sizeof(control);
+
+		size_t count(control >> 1);
+		if(count == 0 || count > words - i)
+			return false;
+
+		if(control & 1){
+			if(end - data < 8)
+				return false;
+			uint64_t value;
+			memcpy(&value, data, 8);
+			data += 8;
+			if(value == 0)
+				memset(out + i * 8, 0, count * 8);
+			else
+				for(size_t j = i; j < i + count; ++j)
+					memcpy(out + j * 8, &value, 8);
+		}
+		else{
+			if(static_cast<size_t>(end - data) < count * 8)
+				return false;
+			memcpy(out + i * 8, data, count * 8);
+			data += count * 8;
+		}
+		i += count;
+	}
+
+	if(static_cast<size_t>(end - data) != outSize % 8)
+		return false;
+	memcpy(out + words * 8, data, outSize % 8);
+	return true;
+}
+
+#ifdef TRIPLEBUFFER_HAVE_LZ4
+inline bool Lz4Codec::compress(const unsigned char* data, size_t size, vector<unsigned char>& out){
+
+	if(size > LZ4_MAX_INPUT_SIZE)
+		return false;
+
+	out.resize(LZ4_compressBound(static_cast<int>(size)));
+	int packed(LZ4_compress_default(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(out.data()),
+			static_cast<int>(size), static_cast<int>(out.size())));
+	if(packed <= 0)
+		return false;
+
+	out.resize(packed);
+	return true;
+}
+
+inline bool Lz4Codec::decompress(const unsigned char* data, size_t size, unsigned char* out, size_t outSize){
+
+	if(size > INT_MAX || outSize > INT_MAX)
+		return false;
+
+	return LZ4_decompress_safe(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(out),
+			static_cast<int>(size), static_cast<int>(outSize)) == static_cast<int>(outSize);
+}
+#endif
+
+template <typename T, typename Codec>
+ColdTripleBuffer<T, Codec>::ColdTripleBuffer(chrono::nanoseconds idle, const Codec& codec) :
+		slotBytes((sizeof(T) + pageSize() - 1) / pageSize() * pageSize()),
+		codec(codec), busy(false), cold(0), packedBytes(0), writing(false), published(0), thawCount(0),
+		idle(idle), lastPublished(0), quietSince(chrono::steady_clock::now()), stopping(false){
+
+	static_assert(is_trivially_copyable<T>::value, "slots are packed and unpacked as bytes");
+
+	void* address(mmap(nullptr, 3 * slotBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	if(address == MAP_FAILED)
+		throw system_error(errno, system_category(), "mmap");
+	region = static_cast<unsigned char*>(address);
+
+	for(uint_fast8_t i = 0; i < 3; ++i)
+		new (slot(i)) T();
+}
+
+template <typename T, typename Codec>
+ColdTripleBuffer<T, Codec>::~ColdTripleBuffer(){
+
+	stopCompactor();
+	munmap(region, 3 * slotBytes);
+}
+
+template <typename T, typename Codec>
+size_t ColdTripleBuffer<T, Codec>::pageSize(){
+
+	return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+template <typename T, typename Codec>
+T* ColdTripleBuffer<T, Codec>::slot(uint_fast8_t index) const{
+
+	return reinterpret_cast<T*>(region + index * slotBytes);
+}
+
+template <typename T, typename Codec>
+void ColdTripleBuffer<T, Codec>::lock(){
+
+	unsigned long spins(0);
+	while(busy.exchange(true, memory_order_acquire))
+		TripleBufferFlags::backoff(spins);
+}
+
+template <typename T, typename Codec>
+bool ColdTripleBuffer<T, Codec>::tryLock(){
+
+	return !busy.load(memory_order_relaxed) && !busy.exchange(true, memory_order_acquire);
+}
+
+template <typename T, typename Codec>
+void ColdTripleBuffer<T, Codec>::unlock(){
+
+	busy.store(false, memory_order_release);
+}
+
+template <typename T, typename Codec>
+void ColdTripleBuffer<T, Codec>::thaw(uint_fast8_t index, bool restore){
+
+	vector<unsigned char>& copy(packed[index]);
+	if(restore && !codec.decompress(copy.data(), copy.size(), reinterpret_cast<unsigned char*>(slot(index)), sizeof(T)))
+		throw runtime_error("ColdTripleBuffer: packed slot does not unpack");
+
+	packedBytes.fetch_sub(copy.size(), memory_order_relaxed);
+	vector<unsigned char>().swap(copy);
+	cold.fetch_and(static_cast<uint8_t>(~(1 << index)), memory_order_relaxed);
+	thawCount.store(thawCount.load(memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+template <typename T, typename Codec>
+size_t ColdTripleBuffer<T, Codec>::freeze(uint_fast8_t index){
+
+	if(cold.load(memory_order_relaxed) & (1 << index))
+		return 0;
+
+	const unsigned char* bytes(reinterpret_cast<const unsigned char*>(slot(index)));
+	if(!codec.compress(bytes, sizeof(T), scratch) || scratch.size() >= slotBytes)
+		return 0;
+
+	packed[index].assign(scratch.begin(), scratch.end());
+	if(madvise(slot(index), slotBytes, MADV_DONTNEED) != 0){ // keep both, the slot stays usable
+		vector<unsigned char>().swap(packed[index]);
+		return 0;
+	}
+
+	packedBytes.fetch_add(scratch.size(), memory_order_relaxed);
+	cold.fetch_or(static_cast<uint8_t>(1 << index), memory_order_relaxed);
+	return slotBytes - scratch.size();
+}
+
+template <typename T, typename Codec>
+const T& ColdTripleBuffer<T, Codec>::snap() const{
+
+	return *slot(flags.snapIndex()); // the snap is never packed
+}
+
+template <typename T, typename Codec>
+T& ColdTripleBuffer<T, Codec>::own(bool restore){
+
+	if(!writing){
+		lock();
+		writing = true;
+	}
+
+	uint_fast8_t index(flags.dirtyIndex());
+	if(cold.load(memory_order_relaxed) & (1 << index)){
+		try {
+			thaw(index, restore);
+		}
+		catch(...){ // the update is abandoned, let compact() and the next update in
+			writing = false;
+			unlock();
+			throw;
+		}
+	}
+	return *slot(index);
+}
+
+template <typename T, typename Codec>
+void ColdTripleBuffer<T, Codec>::write(const T& newT){
+
+	own(false) = newT; // overwritten whole, no need to unpack
+}
+
+template <typename T, typename Codec>
+T& ColdTripleBuffer<T, Codec>::dirty(){
+
+	return own(true);
+}
+
+template <typename T, typename Codec>
+bool ColdTripleBuffer<T, Codec>::newSnap(){
+
+	return flags.newSnap();
+}
+
+template <typename T, typename Codec>
+void ColdTripleBuffer<T, Codec>::flipWriter(){
+
+	dirty(); // the slot becomes readable, it must be unpacked
+	flags.flipWriter();
+	published.store(published.load(memory_order_relaxed) + 1, memory_order_relaxed);
+	writing = false;
+	unlock();
+}
+
+template <typename T, typename Codec>
+size_t ColdTripleBuffer<T, Codec>::compact(){
+
+	chrono::steady_clock::time_point now(chrono::steady_clock::now());
+	uint64_t flips(published.load(memory_order_relaxed));
+	if(flips != lastPublished){
+		lastPublished = flips;
+		quietSince = now;
+	}
+	if(now - quietSince < idle || !tryLock())
+		return 0;
+
+	// the writer is out, so the dirty and clean indexes stay put and nothing new
+	// can be published. Once the reader took the latest value it only ever reads
+	// the snap, so the slot that is neither can be packed too
+	uint_fast8_t dirtyIndex(flags.dirtyIndex());
+	uint_fast8_t latest(flags.latestIndex());
+	size_t released(0);
+	try {
+		released += freeze(dirtyIndex);
+		if(flags.snapIndex() == latest)
+			released += freeze(static_cast<uint_fast8_t>(3 - dirtyIndex - latest));
+	}
+	catch(...){ // out of memory or a failing codec, what was packed stays packed
+		unlock();
+		throw;
+	}
+
+	unlock();
+	return released;
+}
+
+template <typename T, typename Codec>
+void ColdTripleBuffer<T, Codec>::startCompactor(chrono::nanoseconds period){
+
+	if(compactor.joinable())
+		throw logic_error("ColdTripleBuffer: compactor already running");
+
+	stopping = false;
+	compactor = thread([this, period](){
+		unique_lock<mutex> guard(compactorMutex);
+		while(!compactorWake.wait_for(guard, period, [this](){ return stopping; })){
+			guard.unlock();
+			try {
+				compact();
+			}
+			catch(...){
+				// nothing was lost, the slots stay as they were until the next pass
+			}
+			guard.lock();
+		}
+	});
+}
+
+template <typename T, typename Codec>
+void ColdTripleBuffer<T, Codec>::stopCompactor(){
+
+	if(!compactor.joinable())
+		return;
+
+	{
+		lock_guard<mutex> guard(compactorMutex);
+		stopping = true;
+	}
+	compactorWake.notify_all();
+	compactor.join();
+}
+
+template <typename T, typename Codec>
+unsigned ColdTripleBuffer<T, Codec>::coldSlots() const{
+
+	uint8_t mask(cold.load(memory_order_relaxed));
+	return (mask & 1) + (mask >> 1 & 1) + (mask >> 2 & 1);
+}
+
+template <typename T, typename Codec>
+size_t ColdTripleBuffer<T, Codec>::residentBytes() const{
+
+	return (3 - coldSlots()) * slotBytes + packedBytes.load(memory_order_relaxed);
+}
+
+template <typename T, typename Codec>
+uint64_t ColdTripleBuffer<T, Codec>::thaws() const{
+
+	return thawCount.load(memory_order_relaxed);
+}
+
+template <typename T, typename Codec>
+const T& ColdTripleBuffer<T, Codec>::readLast(){
+	newSnap(); // get most recent value
+	return snap(); // return it
+}
+
+template <typename T, typename Codec>
+void ColdTripleBuffer<T, Codec>::update(const T& newT){
+	write(newT); // write new value
+	flipWriter(); // change dirty/clean buffer positions for the next update
+}
+
+#endif /* COLDTRIPLEBUFFER_HXX_ */
@@ -0,0 +1,127 @@
+//============================================================================
+// Name        : CompactTripleBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Triple buffer for tiny T with the flags and the three slots in one cache line
+//============================================================================
+
+#ifndef COMPACTTRIPLEBUFFER_HXX_
+#define COMPACTTRIPLEBUFFER_HXX_
+
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+// Triple buffer for tiny T with the flags and the three slots in a single cache
+// line, so the reader gets both the new flags and the fresh value with one
+// coherence miss. The writer and the reader share that line though, so under a
+// steady stream of updates the padded TripleBuffer<T> layout may do better.
+template <typename T>
+class alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) CompactTripleBuffer
+{
+
+public:
+
+	CompactTripleBuffer<T>();
+	CompactTripleBuffer<T>(const T& init);
+
+	// non-copyable behavior
+	CompactTripleBuffer<T>(const CompactTripleBuffer<T>&) = delete;
+	CompactTripleBuffer<T>& operator=(const CompactTripleBuffer<T>&) = delete;
+
+	T snap() const; // get the current snap to read
+	void write(const T newT); // write a new value
+	bool newSnap(); // swap to the latest value, if any
+	void flipWriter(); // flip writer positions dirty / clean
+
+	T readLast(); // wrapper to read the last available element (newSnap + snap)
+	void update(T newT); // wrapper to update with a new element (write + flipWriter)
+
+private:
+
+	TripleBufferFlags flags; // dirty / clean / snap indexes
+
+	T buffer[3];
+};
+
+// include implementation in header since it is a template
+
+template <typename T>
+CompactTripleBuffer<T>::CompactTripleBuffer() : buffer(){
+
+	static_assert(sizeof(CompactTripleBuffer<T>) <= TRIPLEBUFFER_CACHE_LINE_SIZE,
+			"flags and three slots of T do not fit in a cache line, use TripleBuffer<T>");
+}
+
+template <typename T>
+CompactTripleBuffer<T>::CompactTripleBuffer(const T& init){
+
+	static_assert(sizeof(CompactTripleBuffer<T>) <= TRIPLEBUFFER_CACHE_LINE_SIZE,
+			"flags and three slots of T do not fit in a cache line, use TripleBuffer<T>");
+
+	buffer[0] = init;
+	buffer[1] = init;
+	buffer[2] = init;
+}
+
+template <typename T>
+T CompactTripleBuffer<T>::snap() const{
+
+	return buffer[flags.snapIndex()]; // read snap index
+}
+
+template <typename T>
+void CompactTripleBuffer<T>::write(const T newT){
+
+	buffer[flags.dirtyIndex()] = newT; // write into dirty index
+}
+
+template <typename T>
+bool CompactTripleBuffer<T>::newSnap(){
+
+	return flags.newSnap();
+}
+
+template <typename T>
+void CompactTripleBuffer<T>::flipWriter(){
+
+	flags.flipWriter();
+}
+
+template <typename T>
+T CompactTripleBuffer<T>::readLast(){
+	newSnap(); // get most recent value
+	return snap(); // return it
+}
+
+template <typename T>
+void CompactTripleBuffer<T>::update(T newT){
+	write(newT); // write new value
+	flipWriter(); // change dirty/clean buffer positions for the next update
+}
+
+#endif /* COMPACTTRIPLEBUFFER_HXX_ */
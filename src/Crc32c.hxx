@@ -0,0 +1,171 @@
+//============================================================================
+// Name        : Crc32c.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : CRC32C with SSE4.2 / ARMv8 instructions and a table fallback
+//============================================================================
+
+#ifndef CRC32C_HXX_
+#define CRC32C_HXX_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+using namespace std;
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32C_X86_DISPATCH 1 // SSE4.2 instructions, picked at runtime if the CPU has them
+#endif
+
+// CRC32C (Castagnoli), as used by iSCSI, ext4 and friends. Uses the SSE4.2 crc32
+// instruction when the CPU has it (no -msse4.2 needed) or the ARMv8 CRC
+// extension when compiled for it, and slicing-by-8 tables otherwise.
+class Crc32c
+{
+
+public:
+
+	static uint32_t compute(const void* data, size_t size, uint32_t crc = 0); // crc of data, extending crc of the preceding bytes
+	static uint32_t portable(const void* data, size_t size, uint32_t crc = 0); // same, always with the tables
+	static bool hardware(); // whether compute uses crc instructions
+
+private:
+
+	static uint32_t tables(uint32_t state, const unsigned char* data, size_t size);
+#ifdef CRC32C_X86_DISPATCH
+	__attribute__((target("sse4.2"))) static uint32_t sse42(uint32_t state, const unsigned char* data, size_t size);
+#endif
+
+	struct Table
+	{
+		uint32_t entries[8][256];
+
+		Table();
+	};
+
+	static const uint32_t Polynomial = 0x82f63b78; // reflected 0x1edc6f41
+};
+
+inline uint32_t Crc32c::compute(const void* data, size_t size, uint32_t crc){
+
+	const unsigned char* bytes(static_cast<const unsigned char*>(data));
+
+#if defined(CRC32C_X86_DISPATCH)
+	if(hardware())
+		return ~sse42(~crc, bytes, size);
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+	uint32_t state(~crc);
+	for(; size >= 8; bytes += 8, size -= 8){
+		uint64_t word;
+		memcpy(&word, bytes, 8);
+		state = __crc32cd(state, word);
+	}
+	for(; size; ++bytes, --size)
+		state = __crc32cb(state, *bytes);
+	return ~state;
+#endif
+
+	return ~tables(~crc, bytes, size);
+}
+
+inline uint32_t Crc32c::portable(const void* data, size_t size, uint32_t crc){
+
+	return ~tables(~crc, static_cast<const unsigned char*>(data), size);
+}
+
+inline bool Crc32c::hardware(){
+
+#if defined(CRC32C_X86_DISPATCH)
+	static const bool supported(__builtin_cpu_supports("sse4.2"));
+	return supported;
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+	return true;
+#else
+	return false;
+#endif
+}
+
+inline Crc32c::Table::Table(){
+
+	for(uint32_t byte = 0; byte < 256; ++byte){
+		uint32_t crc(byte);
+		for(int bit = 0; bit < 8; ++bit)
+			crc = (crc >> 1) ^ (Polynomial & (0 - (crc & 1)));
+		entries[0][byte] = crc;
+	}
+	for(uint32_t byte = 0; byte < 256; ++byte)
+		for(int slice = 1; slice < 8; ++slice)
+			entries[slice][byte] = (entries[slice - 1][byte] >> 8) ^ entries[0][entries[slice - 1][byte] & 0xff];
+}
+
+inline uint32_t Crc32c::tables(uint32_t state, const unsigned char* data, size_t size){
+
+	static const Table table;
+	const uint32_t (*t)[256](table.entries);
+
+	// eight bytes per step, little-endian order
+	for(; size >= 8; data += 8, size -= 8){
+		uint32_t low(state ^ (data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24));
+		state = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+				t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+	}
+	for(; size; ++data, --size)
+		state = (state >> 8) ^ t[0][(state ^ *data) & 0xff];
+
+	return state;
+}
+
+#ifdef CRC32C_X86_DISPATCH
+inline uint32_t Crc32c::sse42(uint32_t state, const unsigned char* data, size_t size){
+
+#ifdef __x86_64__
+	uint64_t wide(state);
+	for(; size >= 8; data += 8, size -= 8){
+		uint64_t word;
+		memcpy(&word, data, 8);
+		wide = __builtin_ia32_crc32di(wide, word);
+	}
+	state = static_cast<uint32_t>(wide);
+#endif
+	for(; size >= 4; data += 4, size -= 4){
+		uint32_t word;
+		memcpy(&word, data, 4);
+		state = __builtin_ia32_crc32si(state, word);
+	}
+	for(; size; ++data, --size)
+		state = __builtin_ia32_crc32qi(state, *data);
+
+	return state;
+}
+#endif
+
+#endif /* CRC32C_HXX_ */
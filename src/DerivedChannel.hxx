@@ -0,0 +1,141 @@
+//============================================================================
+// Name        : DerivedChannel.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Latest value channel of a function of a TripleBuffer, computed once per version
+//============================================================================
+
+#ifndef DERIVEDCHANNEL_HXX_
+#define DERIVEDCHANNEL_HXX_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <type_traits>
+
+#include "TripleBuffer.hxx"
+
+using namespace std;
+
+// Latest value channel holding f(snapshot) of a TripleBuffer<T>. It becomes the
+// reader of the source buffer, and any number of threads can read it: the first
+// one asking after a new version is published computes f once, the others share
+// the result. Versions conflated away by the source are never computed.
+//
+// Reads are lock free while the source has nothing newer than the shared result,
+// and while another reader is already computing the next one.
+template <typename T, typename R>
+class DerivedChannel
+{
+
+public:
+
+	DerivedChannel<T, R>(TripleBuffer<T>& source, function<R(const T&)> f);
+
+	// non-copyable behavior
+	DerivedChannel<T, R>(const DerivedChannel<T, R>&) = delete;
+	DerivedChannel<T, R>& operator=(const DerivedChannel<T, R>&) = delete;
+
+	shared_ptr<const R> readLast(); // get f of the latest source value, computing it if needed
+	shared_ptr<const R> readLast(uint64_t& seq); // same, also giving the source sequence number it was computed from
+
+private:
+
+	struct Computed
+	{
+		Computed(R value, uint64_t seq) : value(move(value)), seq(seq) {}
+
+		R value; // f of the source snap
+		uint64_t seq; // source sequence number value was computed from
+	};
+
+	shared_ptr<const R> share(const shared_ptr<const Computed>& computed, uint64_t& seq) const; // hand out the value of computed
+
+	TripleBuffer<T>& source;
+	function<R(const T&)> f;
+
+	mutex lock; // serializes the source reader role and the computation
+	shared_ptr<const Computed> current; // last result, shared with the readers, accessed with atomic_load / atomic_store
+};
+
+// build the derived channel of source through f
+template <typename T, typename F>
+shared_ptr<DerivedChannel<T, typename result_of<F(const T&)>::type> > derive(TripleBuffer<T>& source, F f){
+
+	typedef typename result_of<F(const T&)>::type R;
+	return make_shared<DerivedChannel<T, R> >(source, f);
+}
+
+// include implementation in header since it is a template
+
+template <typename T, typename R>
+DerivedChannel<T, R>::DerivedChannel(TripleBuffer<T>& source, function<R(const T&)> f) :
+		source(source), f(f){
+}
+
+template <typename T, typename R>
+shared_ptr<const R> DerivedChannel<T, R>::readLast(){
+
+	uint64_t seq;
+	return readLast(seq);
+}
+
+template <typename T, typename R>
+shared_ptr<const R> DerivedChannel<T, R>::readLast(uint64_t& seq){
+
+	shared_ptr<const Computed> computed(atomic_load(&current));
+	if(computed && source.latestSeq() == computed->seq)
+		return share(computed, seq); // nothing newer published
+
+	unique_lock<mutex> guard(lock, try_to_lock);
+	if(!guard.owns_lock()){
+		if(computed)
+			return share(computed, seq); // another reader is computing, do not queue behind it
+		guard.lock(); // nothing to share before the first result
+	}
+
+	// compute lazily, the first time and then once per new source version
+	computed = atomic_load(&current);
+	bool fresh(source.newSnap());
+	if(!computed || (fresh && source.snapSeq() != computed->seq)){
+		computed = make_shared<const Computed>(f(source.snapRef()), source.snapSeq());
+		atomic_store(&current, computed);
+	}
+
+	return share(computed, seq);
+}
+
+template <typename T, typename R>
+shared_ptr<const R> DerivedChannel<T, R>::share(const shared_ptr<const Computed>& computed, uint64_t& seq) const{
+
+	seq = computed->seq;
+	return shared_ptr<const R>(computed, &computed->value); // keeps the whole result alive
+}
+
+#endif /* DERIVEDCHANNEL_HXX_ */
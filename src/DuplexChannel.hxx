@@ -0,0 +1,231 @@
+//============================================================================
+// Name        : DuplexChannel.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Pair of latest value channels sharing one control line
+//============================================================================
+
+#ifndef DUPLEXCHANNEL_HXX_
+#define DUPLEXCHANNEL_HXX_
+
+#include <atomic>
+#include <cstdint>
+
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+template <typename A, typename B> class DuplexChannel;
+
+// slot of one direction of a DuplexChannel, the sequence number travels in the
+// same line as the value
+template <typename T>
+struct alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) DuplexSlot
+{
+	uint64_t seq;
+	T value;
+
+	DuplexSlot() : seq(0), value() {}
+};
+
+// One side of a DuplexChannel, writing values of Out and reading values of In.
+// Each side must be used by a single thread.
+template <typename Out, typename In>
+class DuplexEndpoint
+{
+
+public:
+
+	// non-copyable behavior
+	DuplexEndpoint<Out, In>(const DuplexEndpoint<Out, In>&) = delete;
+	DuplexEndpoint<Out, In>& operator=(const DuplexEndpoint<Out, In>&) = delete;
+
+	Out& dirty(); // get the dirty slot to write into in place
+	void flipWriter(); // publish the dirty slot
+	void update(const Out& newOut); // wrapper to publish a new value (write + flipWriter)
+	uint64_t lastPublished() const; // sequence number of the last value published
+	uint64_t lastConsumed() const; // sequence number of the last value the other side took
+
+	bool newSnap(); // swap to the latest value of the other side, if any
+	const In& snap() const; // get the current snap to read
+	uint64_t snapSeq() const; // sequence number of the current snap, 0 for the initial value
+	const In& readLast(); // wrapper to read the last available element (newSnap + snap)
+
+private:
+
+	template <typename, typename> friend class DuplexChannel;
+
+	DuplexEndpoint<Out, In>(atomic<uint16_t>& flags, unsigned outShift, DuplexSlot<Out>* out, atomic<uint64_t>& outAck,
+			unsigned inShift, DuplexSlot<In>* in, atomic<uint64_t>& inAck);
+
+	atomic<uint16_t>& flags; // both directions, one byte each
+	unsigned outShift; // position of the byte of the direction we write
+	DuplexSlot<Out>* out;
+	atomic<uint64_t>& outAck; // written by the other side as it takes our values
+	uint64_t written; // values published so far
+
+	unsigned inShift; // position of the byte of the direction we read
+	DuplexSlot<In>* in;
+	atomic<uint64_t>& inAck; // written by us as we take the other side's values
+};
+
+// Pair of latest value channels between two threads, A values going one way and
+// B values the other, as in a control loop sending state one way and commands
+// back. Both directions share one atomic word of triple buffer flags, which with
+// the acknowledgements of both sides fills one cache line, so a round trip moves
+// that line twice instead of the flags of two separate buffers.
+template <typename A, typename B>
+class DuplexChannel
+{
+
+public:
+
+	DuplexChannel<A, B>();
+
+	// non-copyable behavior
+	DuplexChannel<A, B>(const DuplexChannel<A, B>&) = delete;
+	DuplexChannel<A, B>& operator=(const DuplexChannel<A, B>&) = delete;
+
+	DuplexEndpoint<A, B>& first(); // side writing A and reading B
+	DuplexEndpoint<B, A>& second(); // side writing B and reading A
+
+private:
+
+	// control line, written by both sides
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<uint16_t> flags; // A to B flags in the low byte, B to A in the high one
+	atomic<uint64_t> ackA; // sequence number of the last A value taken by the second side
+	atomic<uint64_t> ackB; // sequence number of the last B value taken by the first side
+
+	DuplexSlot<A> slotsA[3];
+	DuplexSlot<B> slotsB[3];
+
+	DuplexEndpoint<A, B> firstEnd;
+	DuplexEndpoint<B, A> secondEnd;
+};
+
+// include implementation in header since it is a template
+
+template <typename Out, typename In>
+DuplexEndpoint<Out, In>::DuplexEndpoint(atomic<uint16_t>& flags, unsigned outShift, DuplexSlot<Out>* out, atomic<uint64_t>& outAck,
+		unsigned inShift, DuplexSlot<In>* in, atomic<uint64_t>& inAck) :
+		flags(flags), outShift(outShift), out(out), outAck(outAck), written(0),
+		inShift(inShift), in(in), inAck(inAck){
+}
+
+template <typename Out, typename In>
+Out& DuplexEndpoint<Out, In>::dirty(){
+
+	return out[TripleBufferFlags::dirtyOf(flags.load(memory_order_consume) >> outShift)].value; // dirty index
+}
+
+template <typename Out, typename In>
+void DuplexEndpoint<Out, In>::flipWriter(){
+
+	uint16_t flagsNow(flags.load(memory_order_consume));
+	out[TripleBufferFlags::dirtyOf(flagsNow >> outShift)].seq = ++written; // published along with the slot by the flip
+
+	uint16_t flipped;
+	do {
+		uint_fast8_t mine(TripleBufferFlags::newWriteSwapCleanWithDirty((flagsNow >> outShift) & 0xff));
+		flipped = static_cast<uint16_t>((flagsNow & ~(0xff << outShift)) | (mine << outShift));
+	} while(!flags.compare_exchange_weak(flagsNow, flipped, memory_order_release, memory_order_consume));
+}
+
+template <typename Out, typename In>
+void DuplexEndpoint<Out, In>::update(const Out& newOut){
+	dirty() = newOut; // write new value
+	flipWriter(); // publish it
+}
+
+template <typename Out, typename In>
+uint64_t DuplexEndpoint<Out, In>::lastPublished() const{
+
+	return written;
+}
+
+template <typename Out, typename In>
+uint64_t DuplexEndpoint<Out, In>::lastConsumed() const{
+
+	return outAck.load(memory_order_acquire);
+}
+
+template <typename Out, typename In>
+bool DuplexEndpoint<Out, In>::newSnap(){
+
+	uint16_t flagsNow(flags.load(memory_order_consume));
+	uint_fast8_t theirs((flagsNow >> inShift) & 0xff);
+	while(TripleBufferFlags::isNewWrite(theirs)){ // otherwise nothing new, no need to swap
+		uint16_t swapped(static_cast<uint16_t>((flagsNow & ~(0xff << inShift)) |
+				(TripleBufferFlags::swapSnapWithClean(theirs) << inShift)));
+		if(flags.compare_exchange_weak(flagsNow, swapped, memory_order_release, memory_order_consume)){
+			inAck.store(snapSeq(), memory_order_release); // same line as the flags, already ours
+			return true;
+		}
+		theirs = (flagsNow >> inShift) & 0xff;
+	}
+
+	return false;
+}
+
+template <typename Out, typename In>
+const In& DuplexEndpoint<Out, In>::snap() const{
+
+	return in[TripleBufferFlags::snapOf(flags.load(memory_order_consume) >> inShift)].value; // read snap index
+}
+
+template <typename Out, typename In>
+uint64_t DuplexEndpoint<Out, In>::snapSeq() const{
+
+	return in[TripleBufferFlags::snapOf(flags.load(memory_order_consume) >> inShift)].seq; // read snap index
+}
+
+template <typename Out, typename In>
+const In& DuplexEndpoint<Out, In>::readLast(){
+	newSnap(); // get most recent value
+	return snap(); // return it
+}
+
+template <typename A, typename B>
+DuplexChannel<A, B>::DuplexChannel() :
+		flags(TripleBufferFlags::Initial | TripleBufferFlags::Initial << 8), ackA(0), ackB(0),
+		firstEnd(flags, 0, slotsA, ackA, 8, slotsB, ackB),
+		secondEnd(flags, 8, slotsB, ackB, 0, slotsA, ackA){
+}
+
+template <typename A, typename B>
+DuplexEndpoint<A, B>& DuplexChannel<A, B>::first(){
+
+	return firstEnd;
+}
+
+template <typename A, typename B>
+DuplexEndpoint<B, A>& DuplexChannel<A, B>::second(){
+
+	return secondEnd;
+}
+
+#endif /* DUPLEXCHANNEL_HXX_ */
@@ -0,0 +1,157 @@
+//============================================================================
+// Name        : EncodedTripleBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Triple buffer of encoded values decoded lazily on the reader side
+//============================================================================
+
+#ifndef ENCODEDTRIPLEBUFFER_HXX_
+#define ENCODEDTRIPLEBUFFER_HXX_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SmallTripleBuffer.hxx"
+
+using namespace std;
+
+// Triple buffer of values kept in their wire format. The writer publishes the
+// encoded bytes as received, and the reader decodes the snap into a T of its own
+// the first time it is read after a newSnap, so values conflated away are never
+// decoded, and each version the reader consumes is decoded only once.
+//
+// Codec must provide
+//     void decode(const unsigned char* data, size_t size, T& value); // reader side
+// and, only if the typed update(const T&) is used,
+//     void encode(const T& value, vector<unsigned char>& data); // writer side, appends to data
+// The writer and the reader each use their own copy of the codec, so it may keep
+// scratch buffers or statistics without any locking.
+template <typename T, typename Codec, size_t InlineSize = 36>
+class EncodedTripleBuffer
+{
+
+public:
+
+	explicit EncodedTripleBuffer<T, Codec, InlineSize>(const Codec& codec = Codec()); // copied once for each side
+
+	// non-copyable behavior
+	EncodedTripleBuffer<T, Codec, InlineSize>(const EncodedTripleBuffer<T, Codec, InlineSize>&) = delete;
+	EncodedTripleBuffer<T, Codec, InlineSize>& operator=(const EncodedTripleBuffer<T, Codec, InlineSize>&) = delete;
+
+	void publish(const void* data, size_t size); // writer: publish an encoded value as is
+	void update(const T& newT); // writer: encode and publish a value
+
+	bool newSnap(); // swap to the latest value, if any, without decoding it
+	const T& snap(); // the current snap decoded, T() until something is published
+	const T& readLast(); // wrapper to read the last available element (newSnap + snap)
+
+	const unsigned char* snapData() const; // the current snap encoded
+	size_t snapSize() const;
+	uint64_t decodes() const; // values decoded so far
+
+private:
+
+	SmallTripleBuffer<InlineSize> encoded;
+
+	Codec encoder; // writer only
+	vector<unsigned char> scratch; // writer only, encode buffer
+
+	Codec decoder; // reader only
+	T value; // reader only, the snap decoded
+	bool decoded; // value holds the current snap
+	uint64_t decodeCount;
+};
+
+// include implementation in header since it is a template
+
+template <typename T, typename Codec, size_t InlineSize>
+EncodedTripleBuffer<T, Codec, InlineSize>::EncodedTripleBuffer(const Codec& codec) :
+		encoder(codec), decoder(codec), value(), decoded(true), decodeCount(0){
+	// nothing published yet, the empty initial snap stands for T()
+}
+
+template <typename T, typename Codec, size_t InlineSize>
+void EncodedTripleBuffer<T, Codec, InlineSize>::publish(const void* data, size_t size){
+
+	encoded.update(data, size);
+}
+
+template <typename T, typename Codec, size_t InlineSize>
+void EncodedTripleBuffer<T, Codec, InlineSize>::update(const T& newT){
+
+	scratch.clear();
+	encoder.encode(newT, scratch);
+	encoded.update(scratch.data(), scratch.size());
+}
+
+template <typename T, typename Codec, size_t InlineSize>
+bool EncodedTripleBuffer<T, Codec, InlineSize>::newSnap(){
+
+	if(!encoded.newSnap())
+		return false;
+
+	decoded = false; // decode on the first read only
+	return true;
+}
+
+template <typename T, typename Codec, size_t InlineSize>
+const T& EncodedTripleBuffer<T, Codec, InlineSize>::snap(){
+
+	if(!decoded){
+		decoder.decode(encoded.snapData(), encoded.snapSize(), value); // if this throws, the next read tries again
+		decoded = true;
+		++decodeCount;
+	}
+	return value;
+}
+
+template <typename T, typename Codec, size_t InlineSize>
+const T& EncodedTripleBuffer<T, Codec, InlineSize>::readLast(){
+	newSnap(); // get most recent value
+	return snap(); // decode it if needed and return it
+}
+
+template <typename T, typename Codec, size_t InlineSize>
+const unsigned char* EncodedTripleBuffer<T, Codec, InlineSize>::snapData() const{
+
+	return encoded.snapData();
+}
+
+template <typename T, typename Codec, size_t InlineSize>
+size_t EncodedTripleBuffer<T, Codec, InlineSize>::snapSize() const{
+
+	return encoded.snapSize();
+}
+
+template <typename T, typename Codec, size_t InlineSize>
+uint64_t EncodedTripleBuffer<T, Codec, InlineSize>::decodes() const{
+
+	return decodeCount;
+}
+
+#endif /* ENCODEDTRIPLEBUFFER_HXX_ */
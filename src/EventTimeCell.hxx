@@ -0,0 +1,243 @@
+//============================================================================
+// Name        : EventTimeCell.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Multiple producer latest value cell ordered by event time stamps
+//============================================================================
+
+#ifndef EVENTTIMECELL_HXX_
+#define EVENTTIMECELL_HXX_
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+// Latest value cell for several producers, ordered by an event time stamp given
+// with each value instead of by publish order. A publish carrying a stamp not
+// newer than the one of the pending or last consumed value is discarded by the
+// exchange itself, so the reader never goes back to older state.
+//
+// Every producer owns one slot to write into, one slot holds the pending value
+// and one the reader's snap, MaxProducers + 2 in all. The pending slot index, its
+// stamp and whether it is new share one 64 bit word, and a publish swaps the
+// producer's slot with the pending one in a single exchange.
+template <typename T, unsigned MaxProducers = 4>
+class EventTimeCell
+{
+
+public:
+
+	static const uint64_t MaxStamp = (1ULL << 55) - 1;
+
+	// one producing thread's handle, owning its slot
+	class Producer
+	{
+
+	public:
+
+		Producer(Producer&& other); // other can no longer publish
+
+		// non-copyable behavior
+		Producer(const Producer&) = delete;
+		Producer& operator=(const Producer&) = delete;
+
+		T& dirty(); // get the slot to write the next value into in place
+		bool flip(uint64_t stamp); // publish the slot as the value at stamp (1 to MaxStamp), false if it was not newer and got discarded
+		bool publish(uint64_t stamp, const T& value); // wrapper to write and flip
+
+	private:
+
+		friend class EventTimeCell<T, MaxProducers>;
+
+		Producer(EventTimeCell<T, MaxProducers>* cell, uint8_t slot);
+
+		EventTimeCell<T, MaxProducers>* cell;
+		uint8_t slot;
+	};
+
+	EventTimeCell<T, MaxProducers>();
+
+	// non-copyable behavior
+	EventTimeCell<T, MaxProducers>(const EventTimeCell<T, MaxProducers>&) = delete;
+	EventTimeCell<T, MaxProducers>& operator=(const EventTimeCell<T, MaxProducers>&) = delete;
+
+	Producer producer(); // hand a slot to a new producer, throws once MaxProducers have one
+
+	bool newSnap(); // take the pending value, if any
+	const T& snap() const; // get the current snap to read
+	uint64_t snapStamp() const; // stamp of the current snap, 0 for the initial value
+	const T& readLast(); // wrapper to read the last available element (newSnap + snap)
+
+private:
+
+	static_assert(MaxProducers + 2 <= 256, "slot indexes are 8 bits");
+
+	// 64 bit word is (55 bit stamp) (new) (8 bit slot index)
+	static uint64_t stampOf(uint64_t word);
+	static bool isNew(uint64_t word);
+	static uint8_t slotOf(uint64_t word);
+	static uint64_t make(uint64_t stamp, bool fresh, uint8_t slot);
+
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<uint64_t> pending;
+	atomic<unsigned> producers; // producers created so far
+
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) uint8_t snapSlot; // reader only
+	uint64_t stamp; // reader only, stamp of the snap
+
+	T buffer[MaxProducers + 2];
+};
+
+// include implementation in header since it is a template
+
+template <typename T, unsigned MaxProducers>
+const uint64_t EventTimeCell<T, MaxProducers>::MaxStamp;
+
+template <typename T, unsigned MaxProducers>
+EventTimeCell<T, MaxProducers>::EventTimeCell() :
+		pending(make(0, false, MaxProducers)), producers(0), snapSlot(MaxProducers + 1), stamp(0), buffer(){
+	// producer k starts with slot k
+}
+
+template <typename T, unsigned MaxProducers>
+typename EventTimeCell<T, MaxProducers>::Producer EventTimeCell<T, MaxProducers>::producer(){
+
+	unsigned index(producers.fetch_add(1, memory_order_relaxed));
+	if(index >= MaxProducers){
+		producers.fetch_sub(1, memory_order_relaxed);
+		throw runtime_error("EventTimeCell: all producer slots taken");
+	}
+	return Producer(this, static_cast<uint8_t>(index));
+}
+
+template <typename T, unsigned MaxProducers>
+bool EventTimeCell<T, MaxProducers>::newSnap(){
+
+	uint64_t word(pending.load(memory_order_acquire));
+	while(isNew(word)){ // otherwise nothing new, no need to swap
+		// hand our slot back in place of the new one, keeping the stamp so older publishes stay out
+		if(pending.compare_exchange_weak(word, make(stampOf(word), false, snapSlot), memory_order_acq_rel, memory_order_acquire)){
+			snapSlot = slotOf(word);
+			stamp = stampOf(word);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+template <typename T, unsigned MaxProducers>
+const T& EventTimeCell<T, MaxProducers>::snap() const{
+
+	return buffer[snapSlot];
+}
+
+template <typename T, unsigned MaxProducers>
+uint64_t EventTimeCell<T, MaxProducers>::snapStamp() const{
+
+	return stamp;
+}
+
+template <typename T, unsigned MaxProducers>
+const T& EventTimeCell<T, MaxProducers>::readLast(){
+	newSnap(); // get most recent value
+	return snap(); // return it
+}
+
+template <typename T, unsigned MaxProducers>
+uint64_t EventTimeCell<T, MaxProducers>::stampOf(uint64_t word){
+
+	return word >> 9;
+}
+
+template <typename T, unsigned MaxProducers>
+bool EventTimeCell<T, MaxProducers>::isNew(uint64_t word){
+
+	return (word & 0x100) != 0;
+}
+
+template <typename T, unsigned MaxProducers>
+uint8_t EventTimeCell<T, MaxProducers>::slotOf(uint64_t word){
+
+	return static_cast<uint8_t>(word & 0xff);
+}
+
+template <typename T, unsigned MaxProducers>
+uint64_t EventTimeCell<T, MaxProducers>::make(uint64_t stamp, bool fresh, uint8_t slot){
+
+	return stamp << 9 | (fresh ? 0x100 : 0) | slot;
+}
+
+template <typename T, unsigned MaxProducers>
+EventTimeCell<T, MaxProducers>::Producer::Producer(EventTimeCell<T, MaxProducers>* cell, uint8_t slot) :
+		cell(cell), slot(slot){
+}
+
+template <typename T, unsigned MaxProducers>
+EventTimeCell<T, MaxProducers>::Producer::Producer(Producer&& other) :
+		cell(other.cell), slot(other.slot){
+
+	other.cell = nullptr; // the slot has one owner only
+}
+
+template <typename T, unsigned MaxProducers>
+T& EventTimeCell<T, MaxProducers>::Producer::dirty(){
+
+	if(!cell)
+		throw logic_error("EventTimeCell: producer handle was moved from");
+
+	return cell->buffer[slot];
+}
+
+template <typename T, unsigned MaxProducers>
+bool EventTimeCell<T, MaxProducers>::Producer::flip(uint64_t stamp){
+
+	if(!cell)
+		throw logic_error("EventTimeCell: producer handle was moved from");
+	if(stamp == 0 || stamp > MaxStamp)
+		throw out_of_range("EventTimeCell: stamp out of range");
+
+	uint64_t word(cell->pending.load(memory_order_acquire));
+	do {
+		if(stamp <= stampOf(word)) // not newer than the pending or consumed value
+			return false;
+	} while(!cell->pending.compare_exchange_weak(word, make(stamp, true, slot), memory_order_acq_rel, memory_order_acquire));
+
+	slot = slotOf(word); // the value we replaced, or the slot the reader handed back
+	return true;
+}
+
+template <typename T, unsigned MaxProducers>
+bool EventTimeCell<T, MaxProducers>::Producer::publish(uint64_t stamp, const T& value){
+	dirty() = value; // write new value
+	return flip(stamp); // publish it if newer
+}
+
+#endif /* EVENTTIMECELL_HXX_ */
@@ -0,0 +1,244 @@
+//============================================================================
+// Name        : FlightRecorder.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Lock-free circular log of the last protocol events of one side of a buffer
+//============================================================================
+
+#ifndef FLIGHTRECORDER_HXX_
+#define FLIGHTRECORDER_HXX_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+using namespace std;
+
+// Circular log of the last protocol events of one side of a buffer, for post
+// mortem debugging. Only one thread records into a recorder at a time (give the
+// writer and the reader a recorder each), with relaxed stores and no locks, so
+// an event costs a few nanoseconds. Other threads may read it at any time with
+// events(), and dump() can be called from a signal handler on a crash.
+class FlightRecorder
+{
+
+public:
+
+	enum Kind { Flip = 1, Snap = 2 };
+
+	struct Event
+	{
+		uint64_t number; // events recorded before this one
+		uint64_t time; // ticks(), TSC on x86, steady clock nanoseconds elsewhere
+		uint64_t seq; // sequence number published or taken
+		uint32_t thread; // thread id (Linux tid)
+		uint8_t kind;
+		uint8_t retries; // failed exchanges before the flags were swapped, saturated at 255
+	};
+
+	explicit FlightRecorder(const char* name, size_t capacity = 4096); // capacity is rounded up to a power of 2
+
+	// non-copyable behavior
+	FlightRecorder(const FlightRecorder&) = delete;
+	FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+	void record(Kind kind, uint64_t seq, unsigned retries); // log an event, recording thread only
+	uint64_t recorded() const; // events recorded so far, including the overwritten ones
+	vector<Event> events() const; // the events still in the log, oldest first
+	void dump(int fd) const; // write the log as text to fd, async-signal-safe
+
+	static uint64_t ticks(); // event time stamp
+	static uint32_t threadId();
+
+private:
+
+	struct Entry
+	{
+		atomic<uint64_t> number; // number + 1 once complete, 0 while being written
+		atomic<uint64_t> time;
+		atomic<uint64_t> seq;
+		atomic<uint32_t> thread;
+		atomic<uint8_t> kind;
+		atomic<uint8_t> retries;
+	};
+
+	bool read(uint64_t number, Event& event) const; // copy an event, false if overwritten meanwhile
+
+	const char* name;
+	size_t mask;
+	unique_ptr<Entry[]> entries;
+	atomic<uint64_t> head; // events recorded
+};
+
+inline FlightRecorder::FlightRecorder(const char* name, size_t capacity) :
+		name(name), head(0){
+
+	size_t size(1);
+	while(size < capacity)
+		size <<= 1;
+	mask = size - 1;
+
+	entries.reset(new Entry[size]);
+	for(size_t i = 0; i < size; ++i)
+		entries[i].number.store(0, memory_order_relaxed);
+}
+
+inline void FlightRecorder::record(Kind kind, uint64_t seq, unsigned retries){
+
+	uint64_t number(head.load(memory_order_relaxed));
+	Entry& entry(entries[number & mask]);
+
+	// seqlock style, so readers can tell a torn entry
+	entry.number.store(0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	entry.time.store(ticks(), memory_order_relaxed);
+	entry.seq.store(seq, memory_order_relaxed);
+	entry.thread.store(threadId(), memory_order_relaxed);
+	entry.kind.store(static_cast<uint8_t>(kind), memory_order_relaxed);
+	entry.retries.store(retries > 255 ? 255 : static_cast<uint8_t>(retries), memory_order_relaxed);
+	entry.number.store(number + 1, memory_order_release);
+
+	head.store(number + 1, memory_order_release);
+}
+
+inline uint64_t FlightRecorder::recorded() const{
+
+	return head.load(memory_order_acquire);
+}
+
+inline bool FlightRecorder::read(uint64_t number, Event& event) const{
+
+	const Entry& entry(entries[number & mask]);
+	if(entry.number.load(memory_order_acquire) != number + 1)
+		return false;
+
+	event.number = number;
+	event.time = entry.time.load(memory_order_relaxed);
+	event.seq = entry.seq.load(memory_order_relaxed);
+	event.thread = entry.thread.load(memory_order_relaxed);
+	event.kind = entry.kind.load(memory_order_relaxed);
+	event.retries = entry.retries.load(memory_order_relaxed);
+
+	atomic_thread_fence(memory_order_acquire);
+	return entry.number.load(memory_order_relaxed) == number + 1;
+}
+
+inline vector<FlightRecorder::Event> FlightRecorder::events() const{
+
+	uint64_t end(recorded());
+	uint64_t begin(end > mask + 1 ? end - mask - 1 : 0);
+
+	vector<Event> log;
+	log.reserve(end - begin);
+	for(uint64_t number = begin; number < end; ++number){
+		Event event;
+		if(read(number, event))
+			log.push_back(event);
+	}
+	return log;
+}
+
+inline void FlightRecorder::dump(int fd) const{
+
+	// no allocation nor stdio, only write(2), so this works from a signal handler
+	struct Line
+	{
+		char text[160];
+		size_t size;
+
+		Line() : size(0) {}
+		void put(const char* s){ while(*s && size < sizeof(text)) text[size++] = *s++; }
+		void put(uint64_t n){
+			char digits[20];
+			int count(0);
+			do { digits[count++] = static_cast<char>('0' + n % 10); n /= 10; } while(n);
+			while(count && size < sizeof(text)) text[size++] = digits[--count];
+		}
+		void flush(int fd){ ssize_t ignored(::write(fd, text, size)); (void)ignored; size = 0; }
+	};
+
+	uint64_t end(recorded());
+	uint64_t begin(end > mask + 1 ? end - mask - 1 : 0);
+
+	Line line;
+	line.put("flight recorder ");
+	line.put(name);
+	line.put(": ");
+	line.put(end - begin);
+	line.put(" of ");
+	line.put(end);
+	line.put(" events\n");
+	line.flush(fd);
+
+	for(uint64_t number = begin; number < end; ++number){
+		Event event;
+		if(!read(number, event))
+			continue;
+		line.put(event.number);
+		line.put(event.kind == Flip ? " flip" : " snap");
+		line.put(" seq ");
+		line.put(event.seq);
+		line.put(" time ");
+		line.put(event.time);
+		line.put(" retries ");
+		line.put(static_cast<uint64_t>(event.retries));
+		line.put(" thread ");
+		line.put(static_cast<uint64_t>(event.thread));
+		line.put("\n");
+		line.flush(fd);
+	}
+}
+
+inline uint64_t FlightRecorder::ticks(){
+
+#if defined(__i386__) || defined(__x86_64__)
+	return __builtin_ia32_rdtsc();
+#else
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline uint32_t FlightRecorder::threadId(){
+
+#if defined(__linux__)
+	static thread_local uint32_t id(static_cast<uint32_t>(syscall(SYS_gettid)));
+#else
+	static atomic<uint32_t> threads(0);
+	static thread_local uint32_t id(++threads);
+#endif
+	return id;
+}
+
+#endif /* FLIGHTRECORDER_HXX_ */
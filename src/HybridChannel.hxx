@@ -0,0 +1,168 @@
+//============================================================================
+// Name        : HybridChannel.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Latest value channel with a lossless side lane of events ordered against the values
+//============================================================================
+
+#ifndef HYBRIDCHANNEL_HXX_
+#define HYBRIDCHANNEL_HXX_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "TripleBuffer.hxx"
+
+using namespace std;
+
+// Latest value channel with a lossless side lane. Values of T are conflated as
+// in a TripleBuffer, events of E go through a bounded single producer / single
+// consumer queue and are never dropped. Each event is tagged with the number of
+// values published before it, and poll() hands over an event only together with
+// a snap at least that recent, so the reader always sees an event along with the
+// state it happened in (or a later one).
+template <typename T, typename E, size_t Capacity = 1024>
+class HybridChannel
+{
+
+public:
+
+	HybridChannel<T, E, Capacity>();
+
+	// non-copyable behavior
+	HybridChannel<T, E, Capacity>(const HybridChannel<T, E, Capacity>&) = delete;
+	HybridChannel<T, E, Capacity>& operator=(const HybridChannel<T, E, Capacity>&) = delete;
+
+	// writer
+	T& dirty(); // get the dirty slot to write into in place
+	void flipWriter(); // publish the dirty slot
+	void update(const T& newT); // wrapper to publish a new value (write + flipWriter)
+	bool pushEvent(const E& event); // queue an event after the values published so far, false if the lane is full
+
+	// reader
+	template <typename F> bool poll(F onEvent); // take the latest value and the events up to it, whether anything was new
+	const T& snap() const; // the value taken by the last poll
+	uint64_t snapSeq() const; // its sequence number
+	size_t pendingEvents() const; // events queued and not delivered yet
+
+private:
+
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+	struct Entry
+	{
+		uint64_t tag; // values published before the event
+		E event;
+	};
+
+	TripleBuffer<T> values;
+
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<uint64_t> tail; // events pushed, written by the writer
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<uint64_t> head; // events delivered, written by the reader
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) Entry entries[Capacity];
+};
+
+// include implementation in header since it is a template
+
+template <typename T, typename E, size_t Capacity>
+HybridChannel<T, E, Capacity>::HybridChannel() : tail(0), head(0){
+}
+
+template <typename T, typename E, size_t Capacity>
+T& HybridChannel<T, E, Capacity>::dirty(){
+
+	return values.dirty();
+}
+
+template <typename T, typename E, size_t Capacity>
+void HybridChannel<T, E, Capacity>::flipWriter(){
+
+	values.flipWriter();
+}
+
+template <typename T, typename E, size_t Capacity>
+void HybridChannel<T, E, Capacity>::update(const T& newT){
+	values.write(newT); // write new value
+	flipWriter(); // publish it
+}
+
+template <typename T, typename E, size_t Capacity>
+bool HybridChannel<T, E, Capacity>::pushEvent(const E& event){
+
+	uint64_t pushed(tail.load(memory_order_relaxed));
+	if(pushed - head.load(memory_order_acquire) == Capacity)
+		return false;
+
+	Entry& entry(entries[pushed & (Capacity - 1)]);
+	entry.tag = values.lastPublished();
+	entry.event = event;
+	tail.store(pushed + 1, memory_order_release);
+	return true;
+}
+
+template <typename T, typename E, size_t Capacity>
+template <typename F>
+bool HybridChannel<T, E, Capacity>::poll(F onEvent){
+
+	bool fresh(values.newSnap());
+	uint64_t seq(values.snapSeq());
+
+	// events tagged after the snap wait for the poll that takes that value
+	uint64_t delivered(head.load(memory_order_relaxed));
+	uint64_t pushed(tail.load(memory_order_acquire));
+	uint64_t first(delivered);
+	while(delivered != pushed){
+		Entry& entry(entries[delivered & (Capacity - 1)]);
+		if(entry.tag > seq)
+			break;
+		onEvent(static_cast<const E&>(entry.event));
+		head.store(++delivered, memory_order_release);
+	}
+
+	return fresh || delivered != first;
+}
+
+template <typename T, typename E, size_t Capacity>
+const T& HybridChannel<T, E, Capacity>::snap() const{
+
+	return values.snapRef();
+}
+
+template <typename T, typename E, size_t Capacity>
+uint64_t HybridChannel<T, E, Capacity>::snapSeq() const{
+
+	return values.snapSeq();
+}
+
+template <typename T, typename E, size_t Capacity>
+size_t HybridChannel<T, E, Capacity>::pendingEvents() const{
+
+	return static_cast<size_t>(tail.load(memory_order_acquire) - head.load(memory_order_acquire));
+}
+
+#endif /* HYBRIDCHANNEL_HXX_ */
@@ -0,0 +1,327 @@
+//============================================================================
+// Name        : OffsetContainers.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Relocatable offset based vector, string and map allocated in a slot arena
+//============================================================================
+
+#ifndef OFFSETCONTAINERS_HXX_
+#define OFFSETCONTAINERS_HXX_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace std;
+
+// Containers for slot payloads holding variable length data. Everything is
+// allocated from an arena living in the slot itself and referenced through
+// offsets relative to the referencing object, so a slot stays valid when it is
+// mapped at another address (shared memory, files) or copied as a whole with
+// memcpy. The writer builds the payload in place in the dirty slot:
+//
+//	struct Payload {
+//		SlotArena<1 << 16> arena;
+//		OffsetString name;
+//		OffsetVector<double> prices;
+//	};
+//
+//	Payload& p = buffer.dirty();
+//	p.arena.reset(); // drop the contents of two versions ago
+//	p.name.assign(p.arena, "book");
+//	p.prices.clear();
+//	p.prices.push_back(p.arena, 1.5);
+//	buffer.flipWriter();
+//
+// Copying a single container gives a view sharing its elements, and copying a
+// whole payload with its assignment operator would point into the source slot,
+// use memcpy or build it in place instead.
+
+// pointer stored as an offset from itself, 0 being null
+template <typename T>
+class OffsetPtr
+{
+
+public:
+
+	OffsetPtr() : offset(0) {}
+	OffsetPtr(T* target) { set(target); }
+	OffsetPtr(const OffsetPtr<T>& other) { set(other.get()); }
+	OffsetPtr<T>& operator=(const OffsetPtr<T>& other) { set(other.get()); return *this; }
+
+	T* get() const { return offset ? reinterpret_cast<T*>(reinterpret_cast<intptr_t>(this) + offset) : nullptr; }
+	void set(T* target) { offset = target ? reinterpret_cast<intptr_t>(target) - reinterpret_cast<intptr_t>(this) : 0; }
+
+	T& operator*() const { return *get(); }
+	T* operator->() const { return get(); }
+	T& operator[](size_t i) const { return get()[i]; }
+
+private:
+
+	int64_t offset; // from this object to the target
+};
+
+// bump allocator over storage inside the slot, freed all at once by reset()
+template <size_t Capacity>
+class SlotArena
+{
+
+public:
+
+	SlotArena() : used(0) {}
+
+	void* allocate(size_t size, size_t align); // throws bad_alloc when the arena is full
+	void reset() { used = 0; }
+
+	size_t size() const { return used; }
+	size_t capacity() const { return Capacity; }
+
+private:
+
+	uint64_t used;
+	alignas(16) unsigned char storage[Capacity];
+};
+
+// vector of trivially destructible T in an arena, growing by reallocating in it
+template <typename T>
+class OffsetVector
+{
+
+public:
+
+	OffsetVector() : count(0), room(0) {}
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T& operator[](size_t i) { return elements[i]; }
+	const T& operator[](size_t i) const { return elements[i]; }
+	T* begin() { return elements.get(); }
+	T* end() { return elements.get() + count; }
+	const T* begin() const { return elements.get(); }
+	const T* end() const { return elements.get() + count; }
+
+	void clear(); // forget the elements, their memory goes back with the arena reset
+
+	template <typename Arena> void reserve(Arena& arena, size_t capacity);
+	template <typename Arena> void push_back(Arena& arena, const T& value);
+	template <typename Arena> T& insert(Arena& arena, size_t position, const T& value);
+	template <typename Arena, typename It> void assign(Arena& arena, It first, It last);
+
+private:
+
+	OffsetPtr<T> elements;
+	uint32_t count;
+	uint32_t room;
+};
+
+// zero terminated string in an arena
+class OffsetString
+{
+
+public:
+
+	size_t size() const { return chars.empty() ? 0 : chars.size() - 1; }
+	bool empty() const { return size() == 0; }
+	const char* c_str() const { return chars.empty() ? "" : chars.begin(); }
+
+	void clear() { chars.clear(); }
+
+	template <typename Arena> void assign(Arena& arena, const char* s, size_t length);
+	template <typename Arena> void assign(Arena& arena, const char* s) { assign(arena, s, strlen(s)); }
+
+	int compare(const char* s) const { return strcmp(c_str(), s); }
+	int compare(const OffsetString& s) const { return strcmp(c_str(), s.c_str()); }
+
+private:
+
+	OffsetVector<char> chars;
+};
+
+inline bool operator==(const OffsetString& a, const char* b) { return a.compare(b) == 0; }
+inline bool operator==(const OffsetString& a, const OffsetString& b) { return a.compare(b) == 0; }
+inline bool operator<(const OffsetString& a, const char* b) { return a.compare(b) < 0; }
+inline bool operator<(const char* a, const OffsetString& b) { return b.compare(a) > 0; }
+inline bool operator<(const OffsetString& a, const OffsetString& b) { return a.compare(b) < 0; }
+
+// map kept as a sorted vector, suited to maps built once per version and then only read
+template <typename K, typename V>
+class OffsetMap
+{
+
+public:
+
+	struct Entry
+	{
+		K key;
+		V value;
+	};
+
+	size_t size() const { return entries.size(); }
+	bool empty() const { return entries.empty(); }
+	const Entry* begin() const { return entries.begin(); }
+	const Entry* end() const { return entries.end(); }
+
+	void clear() { entries.clear(); }
+
+	template <typename Key> const V* find(const Key& key) const; // null if key is not in the map
+	template <typename Arena> V& insert(Arena& arena, const K& key, const V& value); // insert or replace
+
+private:
+
+	template <typename Key> size_t lowerBound(const Key& key) const;
+
+	OffsetVector<Entry> entries;
+};
+
+// include implementation in header since it is a template
+
+template <size_t Capacity>
+void* SlotArena<Capacity>::allocate(size_t size, size_t align){
+
+	size_t start((used + align - 1) / align * align);
+	if(start + size > Capacity)
+		throw bad_alloc();
+
+	used = start + size;
+	return storage + start;
+}
+
+template <typename T>
+void OffsetVector<T>::clear(){
+
+	elements.set(nullptr);
+	count = 0;
+	room = 0;
+}
+
+template <typename T>
+template <typename Arena>
+void OffsetVector<T>::reserve(Arena& arena, size_t capacity){
+
+	static_assert(is_trivially_destructible<T>::value, "the arena never runs destructors");
+
+	if(capacity <= room)
+		return;
+	if(capacity > UINT32_MAX)
+		throw length_error("OffsetVector capacity does not fit 32 bits");
+
+	T* grown = static_cast<T*>(arena.allocate(capacity * sizeof(T), alignof(T)));
+	for(uint32_t i = 0; i < count; ++i)
+		new (grown + i) T(elements[i]); // copy so offsets inside the elements are rebased
+
+	elements.set(grown);
+	room = static_cast<uint32_t>(capacity);
+}
+
+template <typename T>
+template <typename Arena>
+void OffsetVector<T>::push_back(Arena& arena, const T& value){
+
+	insert(arena, count, value);
+}
+
+template <typename T>
+template <typename Arena>
+T& OffsetVector<T>::insert(Arena& arena, size_t position, const T& value){
+
+	if(count == room)
+		reserve(arena, room ? 2 * size_t(room) : 4);
+
+	T* data(elements.get());
+	if(position == count){
+		new (data + count) T(value);
+	}
+	else {
+		new (data + count) T(data[count - 1]);
+		for(size_t i = count - 1; i > position; --i)
+			data[i] = data[i - 1];
+		data[position] = value;
+	}
+	++count;
+
+	return data[position];
+}
+
+template <typename T>
+template <typename Arena, typename It>
+void OffsetVector<T>::assign(Arena& arena, It first, It last){
+
+	clear();
+	reserve(arena, distance(first, last));
+	for(; first != last; ++first)
+		new (elements.get() + count++) T(*first);
+}
+
+template <typename Arena>
+void OffsetString::assign(Arena& arena, const char* s, size_t length){
+
+	// room for the terminator up front, growing for it would double the copy in the arena
+	chars.clear();
+	chars.reserve(arena, length + 1);
+	for(size_t i = 0; i < length; ++i)
+		chars.push_back(arena, s[i]);
+	chars.push_back(arena, '\0');
+}
+
+template <typename K, typename V>
+template <typename Key>
+size_t OffsetMap<K, V>::lowerBound(const Key& key) const{
+
+	const Entry* found = lower_bound(entries.begin(), entries.end(), key,
+			[](const Entry& entry, const Key& k){ return entry.key < k; });
+	return found - entries.begin();
+}
+
+template <typename K, typename V>
+template <typename Key>
+const V* OffsetMap<K, V>::find(const Key& key) const{
+
+	size_t i(lowerBound(key));
+	if(i == entries.size() || key < entries[i].key)
+		return nullptr;
+	return &entries[i].value;
+}
+
+template <typename K, typename V>
+template <typename Arena>
+V& OffsetMap<K, V>::insert(Arena& arena, const K& key, const V& value){
+
+	size_t i(lowerBound(key));
+	if(i < entries.size() && !(key < entries[i].key)){
+		entries[i].value = value;
+		return entries[i].value;
+	}
+
+	Entry entry = { key, value };
+	return entries.insert(arena, i, entry).value;
+}
+
+#endif /* OFFSETCONTAINERS_HXX_ */
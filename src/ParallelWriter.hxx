@@ -0,0 +1,118 @@
+//============================================================================
+// Name        : ParallelWriter.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Fork-join team of threads writing one TripleBuffer value together
+//============================================================================
+
+#ifndef PARALLELWRITER_HXX_
+#define PARALLELWRITER_HXX_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+// Lets a fixed team of worker threads fill disjoint parts of the dirty slot of a
+// TripleBuffer<T> or ArrayTripleBuffer<T> together. Every worker calls publish()
+// once its part is done, the last one to arrive flips the writer and all of them
+// return once the value is published, so the team acts as a single writer.
+template <typename Buffer>
+class ParallelWriter
+{
+
+public:
+
+	ParallelWriter<Buffer>(Buffer& buffer, unsigned workers);
+
+	// non-copyable behavior
+	ParallelWriter<Buffer>(const ParallelWriter<Buffer>&) = delete;
+	ParallelWriter<Buffer>& operator=(const ParallelWriter<Buffer>&) = delete;
+
+	auto dirty() -> decltype(declval<Buffer&>().dirty()); // get the dirty slot, valid until publish()
+	void publish(); // wait for the whole team, then flip writer positions dirty / clean once
+
+	// split size elements in workers contiguous parts, giving the part [begin, end) of worker
+	static void chunk(size_t size, unsigned worker, unsigned workers, size_t& begin, size_t& end);
+
+private:
+
+	Buffer& buffer;
+	const unsigned workers;
+
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<unsigned> arrived; // workers done with the current value
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<unsigned long> generation; // number of values published
+};
+
+// include implementation in header since it is a template
+
+template <typename Buffer>
+ParallelWriter<Buffer>::ParallelWriter(Buffer& buffer, unsigned workers) : buffer(buffer), workers(workers){
+
+	arrived.store(0, std::memory_order_relaxed);
+	generation.store(0, std::memory_order_relaxed);
+}
+
+template <typename Buffer>
+auto ParallelWriter<Buffer>::dirty() -> decltype(declval<Buffer&>().dirty()){
+
+	return buffer.dirty();
+}
+
+template <typename Buffer>
+void ParallelWriter<Buffer>::publish(){
+
+	unsigned long current(generation.load(std::memory_order_relaxed));
+
+	if(arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == workers){
+		// last one in, every part of the slot is written
+		arrived.store(0, std::memory_order_relaxed);
+		buffer.flipWriter();
+		generation.store(current + 1, std::memory_order_release);
+		return;
+	}
+
+	// wait for the flip, so no worker touches the new dirty slot too early
+	unsigned long spins(0);
+	while(generation.load(std::memory_order_acquire) == current)
+		TripleBufferFlags::backoff(spins);
+}
+
+template <typename Buffer>
+void ParallelWriter<Buffer>::chunk(size_t size, unsigned worker, unsigned workers, size_t& begin, size_t& end){
+
+	size_t part(size / workers), extra(size % workers);
+
+	// the first size % workers parts get one extra element
+	begin = worker * part + (worker < extra ? worker : extra);
+	end = begin + part + (worker < extra ? 1 : 0);
+}
+
+#endif /* PARALLELWRITER_HXX_ */
@@ -0,0 +1,90 @@
+//============================================================================
+// Name        : PersistentTripleBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Triple buffer in a mmap'd file that resumes from its last published slot
+//============================================================================
+
+#ifndef PERSISTENTTRIPLEBUFFER_HXX_
+#define PERSISTENTTRIPLEBUFFER_HXX_
+
+#include <sys/types.h>
+
+#include "SharedTripleBuffer.hxx"
+
+using namespace std;
+
+// Triple buffer whose control block and slots live in a mmap'd regular file, so
+// a restarted writer resumes from the last value it published instead of
+// rebuilding its state. It is a SharedTripleBuffer in integrity mode backed by
+// a file instead of a memfd: the file holds the same control page (magic,
+// sizeof(T), sequence numbers and CRC32C stamps) followed by the three slots.
+//
+// Opening an existing file takes the slot with the highest sequence number that
+// still matches its stamp as the snap, so a slot being written when the process
+// died, or whose pages did not all reach the disk, is skipped. Nothing is
+// deserialized, the slots are used where they are mapped, and readLast() returns
+// the recovered value right away. Other processes can still attach with fd().
+// Only one writer may have the file open (flock), and a file whose writer died
+// before it was complete is built again, as its magic is written last.
+//
+// T must be trivially copyable or offset based (see OffsetContainers.hxx) and
+// have the same layout in every build that opens the file. The page cache keeps
+// the file across a process crash, call sync() after a flip that must also
+// survive a power loss.
+template <typename T>
+class PersistentTripleBuffer : public SharedTripleBuffer<T>
+{
+
+public:
+
+	explicit PersistentTripleBuffer<T>(const char* path, mode_t mode = 0600); // open path, creating it with mode if needed
+
+	bool recovered() const; // whether the file existed and the snap was recovered from it
+	void sync(); // wait until the file on disk holds the region
+};
+
+// include implementation in header since it is a template
+
+template <typename T>
+PersistentTripleBuffer<T>::PersistentTripleBuffer(const char* path, mode_t mode) :
+		SharedTripleBuffer<T>(path, mode){
+}
+
+template <typename T>
+bool PersistentTripleBuffer<T>::recovered() const{
+
+	return this->restored;
+}
+
+template <typename T>
+void PersistentTripleBuffer<T>::sync(){
+
+	this->syncRegion();
+}
+
+#endif /* PERSISTENTTRIPLEBUFFER_HXX_ */
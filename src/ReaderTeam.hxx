@@ -0,0 +1,126 @@
+//============================================================================
+// Name        : ReaderTeam.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Fork-join team of threads sharing one TripleBuffer snap
+//============================================================================
+
+#ifndef READERTEAM_HXX_
+#define READERTEAM_HXX_
+
+#include <atomic>
+
+#include "TripleBuffer.hxx"
+
+using namespace std;
+
+// Lets a fixed team of threads read the same snap of a TripleBuffer<T> without
+// copying it. The leader swaps in the latest value with lead() and starts a new
+// round, the other members pick it up with join(), and everybody calls release()
+// when done. The leader only swaps again once the whole team has released the
+// snap, so the team still behaves as a single reader and needs no extra slot.
+template <typename T>
+class ReaderTeam
+{
+
+public:
+
+	ReaderTeam<T>(TripleBuffer<T>& buffer, unsigned members);
+
+	// non-copyable behavior
+	ReaderTeam<T>(const ReaderTeam<T>&) = delete;
+	ReaderTeam<T>& operator=(const ReaderTeam<T>&) = delete;
+
+	bool lead(); // leader: wait for the team to release the snap, then newSnap and start a new round
+	unsigned long join(unsigned long round); // member: wait for a round newer than round and return it
+	const T& snap() const; // get the snap shared by the current round
+	void release(); // every member, leader included: done with the current round's snap
+
+	unsigned long round() const; // number of rounds started so far
+
+private:
+
+	TripleBuffer<T>& buffer;
+	const unsigned members;
+
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<unsigned> active; // members still holding the snap
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<unsigned long> rounds; // number of rounds started
+};
+
+// include implementation in header since it is a template
+
+template <typename T>
+ReaderTeam<T>::ReaderTeam(TripleBuffer<T>& buffer, unsigned members) : buffer(buffer), members(members){
+
+	active.store(0, std::memory_order_relaxed);
+	rounds.store(0, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool ReaderTeam<T>::lead(){
+
+	unsigned long spins(0);
+	while(active.load(std::memory_order_acquire) != 0) // the snap is still in use
+		TripleBufferFlags::backoff(spins);
+
+	bool fresh(buffer.newSnap());
+
+	active.store(members, std::memory_order_relaxed);
+	rounds.fetch_add(1, std::memory_order_release); // publish the new round to the members
+
+	return fresh;
+}
+
+template <typename T>
+unsigned long ReaderTeam<T>::join(unsigned long round){
+
+	unsigned long spins(0), now;
+	while((now = rounds.load(std::memory_order_acquire)) <= round)
+		TripleBufferFlags::backoff(spins);
+
+	return now;
+}
+
+template <typename T>
+const T& ReaderTeam<T>::snap() const{
+
+	return buffer.snapRef();
+}
+
+template <typename T>
+void ReaderTeam<T>::release(){
+
+	active.fetch_sub(1, std::memory_order_release);
+}
+
+template <typename T>
+unsigned long ReaderTeam<T>::round() const{
+
+	return rounds.load(std::memory_order_acquire);
+}
+
+#endif /* READERTEAM_HXX_ */
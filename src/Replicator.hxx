@@ -0,0 +1,255 @@
+//============================================================================
+// Name        : Replicator.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Block delta replication of a TripleBuffer to another process over a socket
+//============================================================================
+
+#ifndef REPLICATOR_HXX_
+#define REPLICATOR_HXX_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "TripleBuffer.hxx"
+
+using namespace std;
+
+// Wire header of a delta, followed by blocks (uint32_t block index, block bytes)
+struct ReplicaDelta
+{
+	uint64_t seq; // source sequence number of the value
+	uint32_t blocks; // number of blocks that follow
+	uint32_t blockSize; // bytes per block, the last block of T may be shorter
+};
+
+// Reader of a TripleBuffer<T> streaming each new value to another process as the
+// blocks that changed since the last value it sent. Sending blocks, so on a slow
+// link the values published meanwhile are conflated and only the latest one is
+// sent next.
+template <typename T>
+class Replicator
+{
+
+public:
+
+	Replicator<T>(TripleBuffer<T>& source, int socket, size_t blockSize = TRIPLEBUFFER_CACHE_LINE_SIZE); // invalid_argument unless 0 < blockSize <= UINT32_MAX
+
+	// non-copyable behavior
+	Replicator<T>(const Replicator<T>&) = delete;
+	Replicator<T>& operator=(const Replicator<T>&) = delete;
+
+	bool replicateOnce(); // send the latest value if it is new, returns whether something was sent
+	uint64_t bytesSent() const; // bytes written to the socket so far
+
+private:
+
+	TripleBuffer<T>& source;
+	int socket;
+	size_t blockSize;
+
+	unique_ptr<T> sent; // last value sent, which the receiver holds
+	bool sentAny; // the first value is sent whole
+	vector<unsigned char> message; // reused send buffer
+	uint64_t sentBytes;
+};
+
+// Receiving end of a Replicator, applying the deltas to a local copy and
+// publishing it in a local TripleBuffer<T>. Deltas already waiting in the socket
+// are applied together, so only the latest value gets published.
+template <typename T>
+class ReplicaReceiver
+{
+
+public:
+
+	ReplicaReceiver<T>(TripleBuffer<T>& target, int socket);
+
+	// non-copyable behavior
+	ReplicaReceiver<T>(const ReplicaReceiver<T>&) = delete;
+	ReplicaReceiver<T>& operator=(const ReplicaReceiver<T>&) = delete;
+
+	bool receiveOnce(); // wait for deltas, apply them and publish the result, false once the socket is closed
+	uint64_t lastSeq() const; // source sequence number of the last value published
+
+private:
+
+	bool applyOne(); // read and apply one delta, false on end of stream
+	void readAll(void* data, size_t size, bool& closed);
+
+	TripleBuffer<T>& target;
+	int socket;
+
+	unique_ptr<T> replica; // the value as last sent by the Replicator
+	uint64_t seq;
+};
+
+// include implementation in header since it is a template
+
+template <typename T>
+Replicator<T>::Replicator(TripleBuffer<T>& source, int socket, size_t blockSize) :
+		source(source), socket(socket), blockSize(blockSize), sent(new T()), sentAny(false), sentBytes(0){
+
+	static_assert(is_trivially_copyable<T>::value, "values are sent as raw bytes");
+
+	if(blockSize == 0 || blockSize > UINT32_MAX) // sent as a 32 bit field
+		throw invalid_argument("Replicator block size must be in [1, 2^32)");
+}
+
+template <typename T>
+bool Replicator<T>::replicateOnce(){
+
+	if(!source.newSnap() && sentAny)
+		return false;
+
+	const unsigned char* now(reinterpret_cast<const unsigned char*>(&source.snapRef()));
+	unsigned char* before(reinterpret_cast<unsigned char*>(sent.get()));
+
+	ReplicaDelta header = { source.snapSeq(), 0, static_cast<uint32_t>(blockSize) };
+	message.resize(sizeof(header));
+
+	for(size_t offset = 0; offset < sizeof(T); offset += blockSize){
+		size_t size(min(blockSize, sizeof(T) - offset));
+		if(sentAny && memcmp(now + offset, before + offset, size) == 0)
+			continue;
+
+		uint32_t index(static_cast<uint32_t>(offset / blockSize));
+		message.insert(message.end(), reinterpret_cast<unsigned char*>(&index), reinterpret_cast<unsigned char*>(&index) + sizeof(index));
+		message.insert(message.end(), now + offset, now + offset + size);
+		memcpy(before + offset, now + offset, size);
+		++header.blocks;
+	}
+	memcpy(message.data(), &header, sizeof(header));
+
+	for(size_t done = 0; done < message.size(); ){
+		ssize_t written(send(socket, message.data() + done, message.size() - done, MSG_NOSIGNAL));
+		if(written < 0){
+			if(errno == EINTR)
+				continue;
+			throw system_error(errno, system_category(), "Replicator send");
+		}
+		done += written;
+	}
+
+	sentAny = true;
+	sentBytes += message.size();
+	return true;
+}
+
+template <typename T>
+uint64_t Replicator<T>::bytesSent() const{
+
+	return sentBytes;
+}
+
+template <typename T>
+ReplicaReceiver<T>::ReplicaReceiver(TripleBuffer<T>& target, int socket) :
+		target(target), socket(socket), replica(new T()), seq(0){
+
+	static_assert(is_trivially_copyable<T>::value, "values are received as raw bytes");
+}
+
+template <typename T>
+bool ReplicaReceiver<T>::receiveOnce(){
+
+	if(!applyOne())
+		return false;
+
+	// catch up with whatever else already arrived before publishing
+	pollfd pending = { socket, POLLIN, 0 };
+	while(poll(&pending, 1, 0) == 1 && (pending.revents & POLLIN)){
+		if(!applyOne())
+			break;
+	}
+
+	// in place, T may be too large for copies on the stack
+	target.dirty() = *replica;
+	target.flipWriter();
+	return true;
+}
+
+template <typename T>
+bool ReplicaReceiver<T>::applyOne(){
+
+	bool closed(false);
+	ReplicaDelta header;
+	readAll(&header, sizeof(header), closed);
+	if(closed)
+		return false;
+
+	unsigned char* bytes(reinterpret_cast<unsigned char*>(replica.get()));
+	for(uint32_t block = 0; block < header.blocks; ++block){
+		uint32_t index;
+		readAll(&index, sizeof(index), closed);
+		size_t offset(static_cast<size_t>(index) * header.blockSize);
+		if(closed || offset >= sizeof(T))
+			throw system_error(EPROTO, system_category(), "ReplicaReceiver: truncated or corrupt delta");
+
+		readAll(bytes + offset, min<size_t>(header.blockSize, sizeof(T) - offset), closed);
+		if(closed)
+			throw system_error(EPROTO, system_category(), "ReplicaReceiver: truncated delta");
+	}
+
+	seq = header.seq;
+	return true;
+}
+
+template <typename T>
+void ReplicaReceiver<T>::readAll(void* data, size_t size, bool& closed){
+
+	for(size_t done = 0; done < size; ){
+		ssize_t received(recv(socket, static_cast<unsigned char*>(data) + done, size - done, 0));
+		if(received == 0){
+			closed = true;
+			return;
+		}
+		if(received < 0){
+			if(errno == EINTR)
+				continue;
+			throw system_error(errno, system_category(), "ReplicaReceiver recv");
+		}
+		done += received;
+	}
+}
+
+template <typename T>
+uint64_t ReplicaReceiver<T>::lastSeq() const{
+
+	return seq;
+}
+
+#endif /* REPLICATOR_HXX_ */
@@ -0,0 +1,383 @@
+//============================================================================
+// Name        : SharedFanoutBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Shared memory latest value for one writer and many leasing reader processes
+//============================================================================
+
+#ifndef SHAREDFANOUTBUFFER_HXX_
+#define SHAREDFANOUTBUFFER_HXX_
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SharedTripleBuffer.hxx"
+
+using namespace std;
+
+// Latest value region in shared memory for one writer process and up to
+// MaxReaders reader processes that come and go. Each reader leases an entry of
+// the reader table when it attaches and announces there the slot it is reading,
+// hazard pointer style. The writer publishes each value once for all readers and
+// picks the next slot to write among the ones neither published nor announced,
+// and with MaxReaders + 2 slots there is always one, so the writer never waits.
+//
+// Leases of readers that died without detaching are reclaimed by checking their
+// pid (a pid reused by an unrelated process keeps the lease until that process
+// exits), which happens automatically when a reader attaches to a full table.
+template <typename T, unsigned MaxReaders = 32>
+class SharedFanoutBuffer
+{
+
+public:
+
+	explicit SharedFanoutBuffer<T, MaxReaders>(const char* name); // writer: create a new region
+	explicit SharedFanoutBuffer<T, MaxReaders>(int fd); // reader: attach and lease a reader entry, takes ownership of fd
+	~SharedFanoutBuffer<T, MaxReaders>(); // readers give their lease back
+
+	// non-copyable behavior
+	SharedFanoutBuffer<T, MaxReaders>(const SharedFanoutBuffer<T, MaxReaders>&) = delete;
+	SharedFanoutBuffer<T, MaxReaders>& operator=(const SharedFanoutBuffer<T, MaxReaders>&) = delete;
+
+	int fd() const; // memfd to hand to the reader processes
+
+	// writer side
+	T& dirty(); // get the slot to write the next value into in place
+	void write(const T& newT); // write a new value
+	void flipWriter(); // publish the written value to all the readers
+	void update(const T& newT); // wrapper to update with a new element (write + flipWriter)
+
+	// reader side
+	bool newSnap(); // move to the latest value, if any
+	const T& snap() const; // get the current snap to read
+	uint64_t snapSeq() const; // sequence number of the current snap, 0 for the initial value
+	const T& readLast(); // wrapper to read the last available element (newSnap + snap)
+
+	unsigned readers() const; // number of leased reader entries
+	unsigned reclaimDeadReaders(); // give back the leases of readers that are gone, returns how many
+
+private:
+
+	static const unsigned Slots = MaxReaders + 2;
+	static const uint8_t NoSlot = 0xFF;
+	static const int32_t Reclaiming = -1; // pid of an entry being reclaimed
+	static const uint64_t Magic = 0x5452504c46414e31ULL; // "TRPLFAN1"
+
+	struct alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) Lease
+	{
+		atomic<int32_t> pid; // reader holding the lease, 0 when free, Reclaiming while being freed
+		atomic<uint8_t> held; // slot the reader may be reading, NoSlot if none
+	};
+
+	struct Control
+	{
+		uint64_t magic; // identifies the layout, checked when attaching
+		uint64_t slotSize; // sizeof(T) of the writer, checked when attaching
+		uint64_t readerCount; // MaxReaders of the writer, checked when attaching
+
+		alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<uint64_t> latest; // (sequence number << 8) | slot of the latest value
+
+		Lease leases[MaxReaders];
+	};
+
+	static uint64_t pack(uint64_t seq, uint8_t slot) { return (seq << 8) | slot; }
+	static uint8_t slotOf(uint64_t latest) { return latest & 0xFF; }
+	static uint64_t seqOf(uint64_t latest) { return latest >> 8; }
+
+	void map(int prot); // map the whole region with prot
+	void unmap(); // undo map and close the memfd
+	T* slot(uint8_t index) const;
+	void lease(); // take a free reader entry
+	uint8_t freeSlot() const; // a slot neither published nor held by a reader
+
+	int memfd;
+	size_t controlBytes; // control block rounded to a page
+	size_t slotBytes; // one slot rounded to a page
+	size_t regionBytes;
+	unsigned char* region;
+	Control* control;
+
+	// process local state
+	Lease* own; // reader: the leased entry, null for the writer
+	uint8_t current; // writer: slot being written, reader: slot of the snap
+	uint64_t currentSeq; // writer: values published so far, reader: sequence number of the snap
+};
+
+// include implementation in header since it is a template
+
+template <typename T, unsigned MaxReaders>
+SharedFanoutBuffer<T, MaxReaders>::SharedFanoutBuffer(const char* name) :
+		controlBytes(SharedMemory::roundToPage(sizeof(Control))),
+		slotBytes(SharedMemory::roundToPage(sizeof(T))),
+		regionBytes(controlBytes + Slots * slotBytes),
+		own(nullptr), current(1), currentSeq(0){
+
+	static_assert(is_trivially_destructible<T>::value, "slots are never destroyed, the readers may still map them");
+	static_assert(Slots < NoSlot, "the slot index must fit in a byte");
+	static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "atomics must be lock-free to work across processes");
+
+	memfd = SharedMemory::create(name, regionBytes);
+	map(PROT_READ | PROT_WRITE);
+
+	control = new (region) Control();
+	control->magic = Magic;
+	control->slotSize = sizeof(T);
+	control->readerCount = MaxReaders;
+	for(unsigned i = 0; i < MaxReaders; ++i)
+		control->leases[i].held.store(NoSlot, std::memory_order_relaxed);
+	for(uint8_t i = 0; i < Slots; ++i)
+		new (slot(i)) T();
+
+	control->latest.store(pack(0, 0), std::memory_order_release); // initial value in slot 0
+}
+
+template <typename T, unsigned MaxReaders>
+SharedFanoutBuffer<T, MaxReaders>::SharedFanoutBuffer(int fd) :
+		memfd(fd),
+		controlBytes(SharedMemory::roundToPage(sizeof(Control))),
+		slotBytes(SharedMemory::roundToPage(sizeof(T))),
+		regionBytes(controlBytes + Slots * slotBytes),
+		own(nullptr){
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) != regionBytes){
+		close(fd);
+		throw runtime_error("SharedFanoutBuffer: region does not hold a buffer of this type");
+	}
+
+	// the slots are read-only for the readers, only the control block needs writing
+	map(PROT_READ);
+	if(mprotect(region, controlBytes, PROT_READ | PROT_WRITE) != 0){
+		int error(errno);
+		unmap();
+		throw system_error(error, system_category(), "mprotect");
+	}
+
+	control = reinterpret_cast<Control*>(region);
+	if(control->magic != Magic || control->slotSize != sizeof(T) || control->readerCount != MaxReaders){
+		unmap();
+		throw runtime_error("SharedFanoutBuffer: region does not hold a buffer of this type");
+	}
+
+	try {
+		lease();
+	}
+	catch(...){
+		unmap();
+		throw;
+	}
+
+	// start from whatever is the latest value now
+	currentSeq = ~0ULL;
+	newSnap();
+}
+
+template <typename T, unsigned MaxReaders>
+SharedFanoutBuffer<T, MaxReaders>::~SharedFanoutBuffer(){
+
+	if(own){
+		own->held.store(NoSlot, std::memory_order_release);
+		own->pid.store(0, std::memory_order_release);
+	}
+	unmap();
+}
+
+template <typename T, unsigned MaxReaders>
+void SharedFanoutBuffer<T, MaxReaders>::map(int prot){
+
+	void* address(mmap(nullptr, regionBytes, prot, MAP_SHARED, memfd, 0));
+	if(address == MAP_FAILED){
+		int error(errno);
+		close(memfd);
+		throw system_error(error, system_category(), "mmap");
+	}
+	region = static_cast<unsigned char*>(address);
+}
+
+template <typename T, unsigned MaxReaders>
+void SharedFanoutBuffer<T, MaxReaders>::unmap(){
+
+	munmap(region, regionBytes);
+	close(memfd);
+}
+
+template <typename T, unsigned MaxReaders>
+T* SharedFanoutBuffer<T, MaxReaders>::slot(uint8_t index) const{
+
+	return reinterpret_cast<T*>(region + controlBytes + index * slotBytes);
+}
+
+template <typename T, unsigned MaxReaders>
+void SharedFanoutBuffer<T, MaxReaders>::lease(){
+
+	int32_t self(getpid());
+
+	for(int attempt = 0; attempt < 2; ++attempt){
+		for(unsigned i = 0; i < MaxReaders; ++i){
+			int32_t expected(0);
+			if(control->leases[i].pid.compare_exchange_strong(expected, self)){
+				own = &control->leases[i];
+				return;
+			}
+		}
+		if(reclaimDeadReaders() == 0) // table full of live readers
+			break;
+	}
+
+	throw runtime_error("SharedFanoutBuffer: all reader entries are leased");
+}
+
+template <typename T, unsigned MaxReaders>
+int SharedFanoutBuffer<T, MaxReaders>::fd() const{
+
+	return memfd;
+}
+
+template <typename T, unsigned MaxReaders>
+T& SharedFanoutBuffer<T, MaxReaders>::dirty(){
+
+	return *slot(current);
+}
+
+template <typename T, unsigned MaxReaders>
+void SharedFanoutBuffer<T, MaxReaders>::write(const T& newT){
+
+	*slot(current) = newT;
+}
+
+template <typename T, unsigned MaxReaders>
+void SharedFanoutBuffer<T, MaxReaders>::flipWriter(){
+
+	// publish, then look for a free slot: a reader that announced a slot before
+	// checking it was still the latest one shows up in the scan
+	control->latest.store(pack(++currentSeq, current), std::memory_order_seq_cst);
+	current = freeSlot();
+}
+
+template <typename T, unsigned MaxReaders>
+uint8_t SharedFanoutBuffer<T, MaxReaders>::freeSlot() const{
+
+	bool busy[Slots] = {};
+	busy[slotOf(control->latest.load(std::memory_order_relaxed))] = true;
+	for(unsigned i = 0; i < MaxReaders; ++i){
+		uint8_t held(control->leases[i].held.load(std::memory_order_seq_cst));
+		if(held != NoSlot)
+			busy[held] = true;
+	}
+
+	uint8_t index(0);
+	while(busy[index]) // at most MaxReaders + 1 slots are busy
+		++index;
+	return index;
+}
+
+template <typename T, unsigned MaxReaders>
+void SharedFanoutBuffer<T, MaxReaders>::update(const T& newT){
+	write(newT); // write new value
+	flipWriter(); // publish it
+}
+
+template <typename T, unsigned MaxReaders>
+bool SharedFanoutBuffer<T, MaxReaders>::newSnap(){
+
+	uint64_t latest(control->latest.load(std::memory_order_acquire));
+	if(seqOf(latest) == currentSeq) // nothing new
+		return false;
+
+	// announce the slot, then make sure it is still the latest so the writer saw the announcement
+	for(;;){
+		own->held.store(slotOf(latest), std::memory_order_seq_cst);
+		uint64_t check(control->latest.load(std::memory_order_seq_cst));
+		if(check == latest)
+			break;
+		latest = check;
+	}
+
+	current = slotOf(latest);
+	currentSeq = seqOf(latest);
+	return true;
+}
+
+template <typename T, unsigned MaxReaders>
+const T& SharedFanoutBuffer<T, MaxReaders>::snap() const{
+
+	return *slot(current);
+}
+
+template <typename T, unsigned MaxReaders>
+uint64_t SharedFanoutBuffer<T, MaxReaders>::snapSeq() const{
+
+	return currentSeq;
+}
+
+template <typename T, unsigned MaxReaders>
+const T& SharedFanoutBuffer<T, MaxReaders>::readLast(){
+	newSnap(); // get most recent value
+	return snap(); // return it
+}
+
+template <typename T, unsigned MaxReaders>
+unsigned SharedFanoutBuffer<T, MaxReaders>::readers() const{
+
+	unsigned count(0);
+	for(unsigned i = 0; i < MaxReaders; ++i)
+		count += control->leases[i].pid.load(std::memory_order_relaxed) > 0;
+	return count;
+}
+
+template <typename T, unsigned MaxReaders>
+unsigned SharedFanoutBuffer<T, MaxReaders>::reclaimDeadReaders(){
+
+	unsigned reclaimed(0);
+	for(unsigned i = 0; i < MaxReaders; ++i){
+		Lease& entry(control->leases[i]);
+		int32_t pid(entry.pid.load(std::memory_order_acquire));
+		if(pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH)
+			continue;
+
+		// gone without detaching, lock the entry while freeing its slot so a new owner starts clean
+		if(!entry.pid.compare_exchange_strong(pid, Reclaiming))
+			continue;
+		entry.held.store(NoSlot, std::memory_order_seq_cst);
+		entry.pid.store(0, std::memory_order_release);
+		++reclaimed;
+	}
+	return reclaimed;
+}
+
+#endif /* SHAREDFANOUTBUFFER_HXX_ */
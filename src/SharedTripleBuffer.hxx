@@ -0,0 +1,574 @@
+//============================================================================
+// Name        : SharedTripleBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : TripleBuffer in a sealed memfd shared between processes
+//============================================================================
+
+#ifndef SHAREDTRIPLEBUFFER_HXX_
+#define SHAREDTRIPLEBUFFER_HXX_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "Crc32c.hxx"
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+// Helpers for anonymous shared memory (Linux): a sealed memfd with no name in the
+// filesystem, handed to other processes over a UNIX socket.
+class SharedMemory
+{
+
+public:
+
+	static int create(const char* name, size_t size); // sealed memfd of size bytes that can never be resized
+	static void sendFd(int socket, int fd); // pass fd to the process at the other end of socket
+	static int receiveFd(int socket); // receive a fd sent with sendFd
+	static size_t pageSize();
+	static size_t roundToPage(size_t size);
+};
+
+// Triple buffer living in shared memory, for a writer and a reader in different
+// processes. The writer creates it, sends fd() to the reader (for example with
+// SharedMemory::sendFd) and the reader attaches to it. The control block gets its
+// own page, which is the only one the reader maps writable, the slots are mapped
+// read-only on the reader side.
+//
+// T must be usable at any address, so no raw pointers (see OffsetContainers.hxx).
+//
+// In integrity mode flipWriter also stamps the slot with a CRC32C, kept next to
+// its sequence number, which the reader checks with verify(). The stamp is the
+// CRC of the CRCs of each StampBlock bytes, so after markDirty only the marked
+// blocks of the slot are hashed again. The same layout can also live in a
+// regular file that outlives the writer, see PersistentTripleBuffer.hxx.
+template <typename T>
+class SharedTripleBuffer
+{
+
+public:
+
+	explicit SharedTripleBuffer<T>(const char* name, bool integrity = false); // writer: create a new buffer, stamping slots in integrity mode
+	explicit SharedTripleBuffer<T>(int fd); // reader: attach to a buffer created by the writer, takes ownership of fd
+	~SharedTripleBuffer<T>();
+
+	// non-copyable behavior
+	SharedTripleBuffer<T>(const SharedTripleBuffer<T>&) = delete;
+	SharedTripleBuffer<T>& operator=(const SharedTripleBuffer<T>&) = delete;
+
+	int fd() const; // memfd to hand to the reader process
+
+	const T& snap() const; // get the current snap to read
+	uint64_t snapSeq() const; // sequence number of the current snap, 0 for the initial value
+	void write(const T& newT); // write a new value
+	T& dirty(); // get the dirty slot to write into in place
+	bool newSnap(); // swap to the latest value, if any
+	void flipWriter(); // flip writer positions dirty / clean
+	void markDirty(size_t offset, size_t size); // only these bytes of the dirty slot changed, in integrity mode
+
+	bool integrity() const; // whether slots are stamped
+	bool verify() const; // whether the snap matches its stamp, always true without integrity mode
+
+	const T& readLast(); // wrapper to read the last available element (newSnap + snap)
+	void update(const T& newT); // wrapper to update with a new element (write + flipWriter)
+
+protected:
+
+	SharedTripleBuffer<T>(const char* path, mode_t mode); // writer: open or create a file backed buffer, always in integrity mode
+
+	void syncRegion(); // flush the region to its file
+	bool restored; // opened an existing file and recovered its newest good slot
+
+private:
+
+	struct Control
+	{
+		uint64_t magic; // identifies the layout, checked when attaching
+		uint64_t slotSize; // sizeof(T) of the writer, checked when attaching
+		uint64_t written; // writer only, number of values published so far
+		uint64_t seq[3]; // sequence number of the value held by each slot, set by flipWriter
+		uint32_t stamp[3]; // CRC32C of each slot in integrity mode, set by flipWriter
+		uint32_t integrity; // slots are stamped
+
+		alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) TripleBufferFlags flags; // dirty / clean / snap indexes
+	};
+
+	static const uint64_t Magic = 0x5452504c42554632ULL; // "TRPLBUF2"
+	static const size_t StampBlock = 4096; // bytes per block CRC
+
+	void map(int prot); // map the whole region with prot
+	T* slot(uint_fast8_t index) const;
+	static uint32_t blockCrc(const T* value, size_t block);
+	uint32_t rehash(uint_fast8_t index); // writer: hash the stale blocks of a slot again, returns its stamp
+	void stamp(uint_fast8_t index); // writer: rehash and stamp a slot
+	void build(bool integrity); // writer: construct control and slots, all but the magic
+	void recover(); // writer: resume from the newest slot matching its stamp
+
+	int memfd;
+	size_t controlBytes; // control block rounded to a page
+	size_t slotBytes; // one slot rounded to a page
+	size_t regionBytes;
+	unsigned char* region;
+	Control* control;
+
+	// writer only, integrity mode
+	vector<uint32_t> blockCrcs[3]; // CRC of each block of each slot
+	vector<unsigned char> staleBlocks[3]; // blocks changed since the slot was last stamped
+	bool ranged; // markDirty was used since the last flip
+};
+
+// include implementation in header since it is a template
+
+inline int SharedMemory::create(const char* name, size_t size){
+
+	int fd(memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING));
+	if(fd < 0)
+		throw system_error(errno, system_category(), "memfd_create");
+
+	// size it once and for all, so neither side can pull the pages from under the other
+	if(ftruncate(fd, size) != 0 ||
+	   fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0){
+		int error(errno);
+		close(fd);
+		throw system_error(error, system_category(), "sealing memfd");
+	}
+
+	return fd;
+}
+
+inline void SharedMemory::sendFd(int socket, int fd){
+
+	char byte(0);
+	iovec data = { &byte, 1 };
+
+	union { // aligned room for the control message
+		cmsghdr header;
+		char space[CMSG_SPACE(sizeof(int))];
+	} control;
+	memset(&control, 0, sizeof(control));
+
+	msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &data;
+	message.msg_iovlen = 1;
+	message.msg_control = control.space;
+	message.msg_controllen = sizeof(control.space);
+
+	cmsghdr* rights(CMSG_FIRSTHDR(&message));
+	rights->cmsg_level = SOL_SOCKET;
+	rights->cmsg_type = SCM_RIGHTS;
+	rights->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(rights), &fd, sizeof(int));
+
+	if(sendmsg(socket, &message, MSG_NOSIGNAL) != 1)
+		throw system_error(errno, system_category(), "sendmsg");
+}
+
+inline int SharedMemory::receiveFd(int socket){
+
+	char byte;
+	iovec data = { &byte, 1 };
+
+	union { // aligned room for the control message
+		cmsghdr header;
+		char space[CMSG_SPACE(sizeof(int))];
+	} control;
+
+	msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &data;
+	message.msg_iovlen = 1;
+	message.msg_control = control.space;
+	message.msg_controllen = sizeof(control.space);
+
+	ssize_t received(recvmsg(socket, &message, MSG_CMSG_CLOEXEC));
+	if(received < 0)
+		throw system_error(errno, system_category(), "recvmsg");
+
+	cmsghdr* rights(CMSG_FIRSTHDR(&message));
+	if(received == 0 || !rights || rights->cmsg_level != SOL_SOCKET || rights->cmsg_type != SCM_RIGHTS)
+		throw runtime_error("receiveFd: no file descriptor received");
+
+	int fd;
+	memcpy(&fd, CMSG_DATA(rights), sizeof(int));
+	return fd;
+}
+
+inline size_t SharedMemory::pageSize(){
+
+	return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+inline size_t SharedMemory::roundToPage(size_t size){
+
+	size_t page(pageSize());
+	return (size + page - 1) / page * page;
+}
+
+template <typename T>
+SharedTripleBuffer<T>::SharedTripleBuffer(const char* name, bool integrity) :
+		restored(false),
+		controlBytes(SharedMemory::roundToPage(sizeof(Control))),
+		slotBytes(SharedMemory::roundToPage(sizeof(T))),
+		regionBytes(controlBytes + 3 * slotBytes),
+		ranged(false){
+
+	static_assert(is_trivially_destructible<T>::value, "slots are never destroyed, the reader may still map them");
+	static_assert(ATOMIC_CHAR_LOCK_FREE == 2, "the flags must be lock-free to work across processes");
+
+	memfd = SharedMemory::create(name, regionBytes);
+	map(PROT_READ | PROT_WRITE);
+	build(integrity);
+	control->magic = Magic;
+}
+
+template <typename T>
+SharedTripleBuffer<T>::SharedTripleBuffer(int fd) :
+		restored(false),
+		memfd(fd),
+		controlBytes(SharedMemory::roundToPage(sizeof(Control))),
+		slotBytes(SharedMemory::roundToPage(sizeof(T))),
+		regionBytes(controlBytes + 3 * slotBytes),
+		ranged(false){
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) != regionBytes){
+		close(fd);
+		throw runtime_error("SharedTripleBuffer: region does not hold a buffer of this type");
+	}
+
+	// the slots are read-only for the reader, only the flags need writing
+	map(PROT_READ);
+	if(mprotect(region, controlBytes, PROT_READ | PROT_WRITE) != 0){
+		int error(errno);
+		munmap(region, regionBytes);
+		close(fd);
+		throw system_error(error, system_category(), "mprotect");
+	}
+
+	control = reinterpret_cast<Control*>(region);
+	if(control->magic != Magic || control->slotSize != sizeof(T)){
+		munmap(region, regionBytes);
+		close(fd);
+		throw runtime_error("SharedTripleBuffer: region does not hold a buffer of this type");
+	}
+}
+
+template <typename T>
+SharedTripleBuffer<T>::SharedTripleBuffer(const char* path, mode_t mode) :
+		restored(false),
+		controlBytes(SharedMemory::roundToPage(sizeof(Control))),
+		slotBytes(SharedMemory::roundToPage(sizeof(T))),
+		regionBytes(controlBytes + 3 * slotBytes),
+		ranged(false){
+
+	static_assert(is_trivially_destructible<T>::value, "slots are never destroyed, the reader may still map them");
+	static_assert(ATOMIC_CHAR_LOCK_FREE == 2, "the flags must be lock-free to work across processes");
+
+	memfd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, mode);
+	if(memfd < 0)
+		throw system_error(errno, system_category(), "open");
+
+	// two writers would flip and stamp the same slots
+	if(flock(memfd, LOCK_EX | LOCK_NB) != 0){
+		int error(errno);
+		close(memfd);
+		if(error == EWOULDBLOCK)
+			throw runtime_error("SharedTripleBuffer: file already open by another writer");
+		throw system_error(error, system_category(), "flock");
+	}
+
+	struct stat info;
+	if(fstat(memfd, &info) != 0 || (info.st_size != 0 && static_cast<size_t>(info.st_size) != regionBytes)){
+		close(memfd);
+		throw runtime_error("SharedTripleBuffer: file does not hold a buffer of this type");
+	}
+
+	if(info.st_size == 0 && ftruncate(memfd, regionBytes) != 0){
+		int error(errno);
+		close(memfd);
+		throw system_error(error, system_category(), "ftruncate");
+	}
+
+	map(PROT_READ | PROT_WRITE);
+	control = reinterpret_cast<Control*>(region);
+	if(control->magic == 0){
+		// new file, or a writer that died before it was complete: the magic reaches
+		// the disk only once everything else did, so a file with it is whole
+		try {
+			build(true);
+			syncRegion();
+			control->magic = Magic;
+			syncRegion();
+		}
+		catch(...){
+			munmap(region, regionBytes);
+			close(memfd);
+			throw;
+		}
+		return;
+	}
+
+	if(control->magic != Magic || control->slotSize != sizeof(T) || !control->integrity){
+		munmap(region, regionBytes);
+		close(memfd);
+		throw runtime_error("SharedTripleBuffer: file does not hold a buffer of this type");
+	}
+	recover();
+	restored = true;
+}
+
+template <typename T>
+void SharedTripleBuffer<T>::build(bool integrity){
+
+	// everything is value initialized, over zeroed pages or what an incomplete file left
+	control = new (region) Control();
+	control->slotSize = sizeof(T);
+	control->integrity = integrity;
+	for(uint_fast8_t i = 0; i < 3; ++i){
+		new (slot(i)) T();
+		if(integrity){
+			size_t blocks((sizeof(T) + StampBlock - 1) / StampBlock);
+			blockCrcs[i].resize(blocks);
+			staleBlocks[i].assign(blocks, 1);
+			stamp(i);
+		}
+	}
+}
+
+template <typename T>
+void SharedTripleBuffer<T>::recover(){
+
+	// whatever was in flight when the writer died, the dirty slot or a slot whose
+	// pages did not all reach the disk, fails its stamp and the newest good one wins
+	uint_fast8_t order[3] = { 0, 1, 2 };
+	sort(order, order + 3, [this](uint_fast8_t a, uint_fast8_t b){ return control->seq[a] > control->seq[b]; });
+
+	size_t blocks((sizeof(T) + StampBlock - 1) / StampBlock);
+	uint_fast8_t snap(3);
+	for(uint_fast8_t i : order){
+		blockCrcs[i].resize(blocks);
+		staleBlocks[i].assign(blocks, 1);
+		if(rehash(i) == control->stamp[i] && snap == 3)
+			snap = i;
+	}
+	if(snap == 3){
+		munmap(region, regionBytes);
+		close(memfd);
+		throw runtime_error("SharedTripleBuffer: no slot of the file matches its stamp");
+	}
+
+	// the newest good slot becomes the snap, of the other two the older one is dirty
+	uint_fast8_t clean(3), dirty(3);
+	for(uint_fast8_t i : order){
+		if(i == snap)
+			continue;
+		if(clean == 3)
+			clean = i;
+		else
+			dirty = i;
+	}
+	new (&control->flags) TripleBufferFlags(dirty, clean, snap);
+	control->written = control->seq[order[0]];
+}
+
+template <typename T>
+SharedTripleBuffer<T>::~SharedTripleBuffer(){
+
+	munmap(region, regionBytes);
+	close(memfd);
+}
+
+template <typename T>
+void SharedTripleBuffer<T>::map(int prot){
+
+	void* address(mmap(nullptr, regionBytes, prot, MAP_SHARED, memfd, 0));
+	if(address == MAP_FAILED){
+		int error(errno);
+		close(memfd);
+		throw system_error(error, system_category(), "mmap");
+	}
+	region = static_cast<unsigned char*>(address);
+}
+
+template <typename T>
+T* SharedTripleBuffer<T>::slot(uint_fast8_t index) const{
+
+	return reinterpret_cast<T*>(region + controlBytes + index * slotBytes);
+}
+
+template <typename T>
+const size_t SharedTripleBuffer<T>::StampBlock;
+
+template <typename T>
+uint32_t SharedTripleBuffer<T>::blockCrc(const T* value, size_t block){
+
+	size_t offset(block * StampBlock);
+	return Crc32c::compute(reinterpret_cast<const unsigned char*>(value) + offset, min(StampBlock, sizeof(T) - offset));
+}
+
+template <typename T>
+uint32_t SharedTripleBuffer<T>::rehash(uint_fast8_t index){
+
+	vector<uint32_t>& crcs(blockCrcs[index]);
+	vector<unsigned char>& stale(staleBlocks[index]);
+	for(size_t block = 0; block < crcs.size(); ++block){
+		if(stale[block]){
+			crcs[block] = blockCrc(slot(index), block);
+			stale[block] = 0;
+		}
+	}
+	return Crc32c::compute(crcs.data(), crcs.size() * sizeof(uint32_t));
+}
+
+template <typename T>
+void SharedTripleBuffer<T>::stamp(uint_fast8_t index){
+
+	control->stamp[index] = rehash(index);
+}
+
+template <typename T>
+void SharedTripleBuffer<T>::syncRegion(){
+
+	if(msync(region, regionBytes, MS_SYNC) != 0)
+		throw system_error(errno, system_category(), "msync");
+}
+
+template <typename T>
+int SharedTripleBuffer<T>::fd() const{
+
+	return memfd;
+}
+
+template <typename T>
+const T& SharedTripleBuffer<T>::snap() const{
+
+	return *slot(control->flags.snapIndex()); // read snap index
+}
+
+template <typename T>
+uint64_t SharedTripleBuffer<T>::snapSeq() const{
+
+	return control->seq[control->flags.snapIndex()]; // read snap index
+}
+
+template <typename T>
+void SharedTripleBuffer<T>::write(const T& newT){
+
+	*slot(control->flags.dirtyIndex()) = newT; // write into dirty index
+}
+
+template <typename T>
+T& SharedTripleBuffer<T>::dirty(){
+
+	return *slot(control->flags.dirtyIndex()); // dirty index
+}
+
+template <typename T>
+bool SharedTripleBuffer<T>::newSnap(){
+
+	return control->flags.newSnap();
+}
+
+template <typename T>
+void SharedTripleBuffer<T>::flipWriter(){
+
+	uint_fast8_t index(control->flags.dirtyIndex());
+	if(control->integrity){
+		if(!ranged) // written without saying where, the whole slot may have changed
+			staleBlocks[index].assign(staleBlocks[index].size(), 1);
+		stamp(index);
+		ranged = false;
+	}
+	control->seq[index] = ++control->written; // published along with the slot by the flip
+	control->flags.flipWriter();
+}
+
+template <typename T>
+void SharedTripleBuffer<T>::markDirty(size_t offset, size_t size){
+
+	if(!control->integrity || size == 0)
+		return;
+
+	vector<unsigned char>& stale(staleBlocks[control->flags.dirtyIndex()]);
+	size_t end(min(offset + size, sizeof(T)));
+	for(size_t block = offset / StampBlock; block * StampBlock < end; ++block)
+		stale[block] = 1;
+	ranged = true;
+}
+
+template <typename T>
+bool SharedTripleBuffer<T>::integrity() const{
+
+	return control->integrity != 0;
+}
+
+template <typename T>
+bool SharedTripleBuffer<T>::verify() const{
+
+	if(!control->integrity)
+		return true;
+
+	uint_fast8_t index(control->flags.snapIndex()); // read snap index
+	uint32_t crc(0);
+	for(size_t block = 0; block * StampBlock < sizeof(T); ++block){
+		uint32_t bytes(blockCrc(slot(index), block));
+		crc = Crc32c::compute(&bytes, sizeof(bytes), crc);
+	}
+	return crc == control->stamp[index];
+}
+
+template <typename T>
+const T& SharedTripleBuffer<T>::readLast(){
+	newSnap(); // get most recent value
+	return snap(); // return it
+}
+
+template <typename T>
+void SharedTripleBuffer<T>::update(const T& newT){
+	write(newT); // write new value
+	flipWriter(); // change dirty/clean buffer positions for the next update
+}
+
+#endif /* SHAREDTRIPLEBUFFER_HXX_ */
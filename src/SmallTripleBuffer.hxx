@@ -0,0 +1,189 @@
+//============================================================================
+// Name        : SmallTripleBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Triple buffer for variable sized messages, small ones inline and large ones out-of-line
+//============================================================================
+
+#ifndef SMALLTRIPLEBUFFER_HXX_
+#define SMALLTRIPLEBUFFER_HXX_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+// Triple buffer for variable sized messages. Messages up to InlineSize bytes are
+// stored inline in the slots, so with the default size the flags and the three
+// slots fit in two cache lines. Larger messages go to an out-of-line block owned
+// by the slot, which is kept and reused by the following large messages.
+template <size_t InlineSize = 36>
+class SmallTripleBuffer
+{
+
+public:
+
+	SmallTripleBuffer<InlineSize>();
+	~SmallTripleBuffer<InlineSize>();
+
+	// non-copyable behavior
+	SmallTripleBuffer<InlineSize>(const SmallTripleBuffer<InlineSize>&) = delete;
+	SmallTripleBuffer<InlineSize>& operator=(const SmallTripleBuffer<InlineSize>&) = delete;
+
+	const unsigned char* snapData() const; // get the current snap message to read
+	size_t snapSize() const; // size in bytes of the current snap message
+	void write(const void* data, size_t size); // write a new message, length_error from 4 GiB on
+	bool newSnap(); // swap to the latest message, if any
+	void flipWriter(); // flip writer positions dirty / clean
+
+	void update(const void* data, size_t size); // wrapper to update with a new message (write + flipWriter)
+	void reserve(size_t size); // pre-allocate the out-of-line blocks of all slots (not thread safe)
+
+private:
+
+	struct Slot
+	{
+		uint32_t size;
+		unsigned char data[InlineSize];
+	};
+
+	struct Block
+	{
+		unsigned char* data;
+		size_t capacity;
+	};
+
+	static void grow(Block& block, size_t size); // make sure block can hold size bytes
+
+	// hot part, read on every access
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) TripleBufferFlags flags; // dirty / clean / snap indexes
+	Slot slots[3];
+
+	// cold part, only touched by messages larger than InlineSize
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) Block blocks[3];
+};
+
+// include implementation in header since it is a template
+
+template <size_t InlineSize>
+SmallTripleBuffer<InlineSize>::SmallTripleBuffer(){
+
+	for(int i = 0; i < 3; ++i){
+		slots[i].size = 0;
+		blocks[i].data = nullptr;
+		blocks[i].capacity = 0;
+	}
+}
+
+template <size_t InlineSize>
+SmallTripleBuffer<InlineSize>::~SmallTripleBuffer(){
+
+	for(int i = 0; i < 3; ++i)
+		free(blocks[i].data);
+}
+
+template <size_t InlineSize>
+const unsigned char* SmallTripleBuffer<InlineSize>::snapData() const{
+
+	uint_fast8_t snap(flags.snapIndex());
+	if(slots[snap].size <= InlineSize)
+		return slots[snap].data;
+	return blocks[snap].data;
+}
+
+template <size_t InlineSize>
+size_t SmallTripleBuffer<InlineSize>::snapSize() const{
+
+	return slots[flags.snapIndex()].size;
+}
+
+template <size_t InlineSize>
+void SmallTripleBuffer<InlineSize>::write(const void* data, size_t size){
+
+	if(size > UINT32_MAX) // the slot size is 32 bits to keep the slots in two cache lines
+		throw length_error("SmallTripleBuffer message does not fit 32 bits");
+
+	uint_fast8_t dirty(flags.dirtyIndex());
+	if(size <= InlineSize){
+		memcpy(slots[dirty].data, data, size);
+	}
+	else {
+		grow(blocks[dirty], size);
+		memcpy(blocks[dirty].data, data, size);
+	}
+	slots[dirty].size = static_cast<uint32_t>(size);
+}
+
+template <size_t InlineSize>
+bool SmallTripleBuffer<InlineSize>::newSnap(){
+
+	return flags.newSnap();
+}
+
+template <size_t InlineSize>
+void SmallTripleBuffer<InlineSize>::flipWriter(){
+
+	flags.flipWriter();
+}
+
+template <size_t InlineSize>
+void SmallTripleBuffer<InlineSize>::update(const void* data, size_t size){
+	write(data, size); // write new message
+	flipWriter(); // change dirty/clean buffer positions for the next update
+}
+
+template <size_t InlineSize>
+void SmallTripleBuffer<InlineSize>::reserve(size_t size){
+
+	for(int i = 0; i < 3; ++i)
+		grow(blocks[i], size);
+}
+
+template <size_t InlineSize>
+void SmallTripleBuffer<InlineSize>::grow(Block& block, size_t size){
+
+	if(size <= block.capacity)
+		return;
+
+	size_t capacity(block.capacity ? block.capacity : TRIPLEBUFFER_CACHE_LINE_SIZE);
+	while(capacity < size)
+		capacity *= 2; // grow geometrically so the block settles after a few large messages
+
+	free(block.data); // old contents are stale, no need to copy them
+	block.data = static_cast<unsigned char*>(malloc(capacity));
+	block.capacity = block.data ? capacity : 0;
+	if(!block.data)
+		throw bad_alloc();
+}
+
+#endif /* SMALLTRIPLEBUFFER_HXX_ */
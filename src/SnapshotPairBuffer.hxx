@@ -0,0 +1,231 @@
+//============================================================================
+// Name        : SnapshotPairBuffer.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Buffer giving the reader the two most recent values with their publish times
+//============================================================================
+
+#ifndef SNAPSHOTPAIRBUFFER_HXX_
+#define SNAPSHOTPAIRBUFFER_HXX_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "TripleBufferFlags.hxx"
+
+using namespace std;
+
+// Buffer giving the reader the two most recent published values, with their
+// publish times, for consumers interpolating between them. Five slots: the
+// writer's dirty one, the latest and previous values not taken yet, and the
+// latest and previous values the reader holds. previous() is always the value
+// published right before latest(), even when values in between were conflated,
+// and both are read in place.
+template <typename T>
+class SnapshotPairBuffer
+{
+
+public:
+
+	SnapshotPairBuffer<T>();
+	SnapshotPairBuffer<T>(const T& init);
+
+	// non-copyable behavior
+	SnapshotPairBuffer<T>(const SnapshotPairBuffer<T>&) = delete;
+	SnapshotPairBuffer<T>& operator=(const SnapshotPairBuffer<T>&) = delete;
+
+	// writer
+	T& dirty(); // get the dirty slot to write into in place
+	void write(const T& newT); // write a new value
+	void flipWriter(); // publish the dirty slot, stamped with the current time
+	void update(const T& newT); // wrapper to update with a new element (write + flipWriter)
+
+	// reader
+	bool newSnap(); // take the latest value and the one published before it, if there is a new one
+	const T& latest() const; // the latest value taken
+	const T& previous() const; // the value published right before it
+	uint64_t latestTime() const; // publish time of latest(), steady clock nanoseconds, 0 for the initial value
+	uint64_t previousTime() const;
+	uint64_t latestSeq() const; // sequence number of latest(), 0 for the initial value
+	uint64_t previousSeq() const;
+
+private:
+
+	// 32 bit flags are 3 bit slot indexes and two bits
+	// dirty          = bits 0-2
+	// pendingLatest  = bits 3-5, published and not taken yet if NewLatest
+	// pendingPrev    = bits 6-8, published right before pendingLatest and not taken yet if HasPrev
+	// latest         = bits 9-11, held by the reader
+	// previous       = bits 12-14, held by the reader
+	enum { Dirty = 0, PendingLatest = 3, PendingPrev = 6, Latest = 9, Previous = 12, NewLatest = 1 << 15, HasPrev = 1 << 16 };
+
+	static uint32_t index(uint32_t flags, unsigned field);
+	static uint32_t with(uint32_t flags, unsigned field, uint32_t index);
+	static uint32_t flipped(uint32_t flags);
+	static uint32_t taken(uint32_t flags);
+
+	alignas(TRIPLEBUFFER_CACHE_LINE_SIZE) atomic<uint32_t> flags;
+
+	uint64_t written; // writer only, number of values published so far
+	uint64_t seq[5]; // sequence number of the value held by each slot, set by flipWriter
+	uint64_t time[5]; // publish time of each slot, set by flipWriter
+
+	T buffer[5];
+};
+
+// include implementation in header since it is a template
+
+template <typename T>
+SnapshotPairBuffer<T>::SnapshotPairBuffer() : written(0), seq(), time(), buffer(){
+
+	flags.store(with(with(with(with(0, PendingLatest, 1), PendingPrev, 2), Latest, 3), Previous, 4), memory_order_relaxed);
+}
+
+template <typename T>
+SnapshotPairBuffer<T>::SnapshotPairBuffer(const T& init) : written(0), seq(), time(){
+
+	for(int i = 0; i < 5; ++i)
+		buffer[i] = init;
+	flags.store(with(with(with(with(0, PendingLatest, 1), PendingPrev, 2), Latest, 3), Previous, 4), memory_order_relaxed);
+}
+
+template <typename T>
+uint32_t SnapshotPairBuffer<T>::index(uint32_t flags, unsigned field){
+
+	return (flags >> field) & 0x7;
+}
+
+template <typename T>
+uint32_t SnapshotPairBuffer<T>::with(uint32_t flags, unsigned field, uint32_t index){
+
+	return (flags & ~(0x7u << field)) | (index << field);
+}
+
+template <typename T>
+uint32_t SnapshotPairBuffer<T>::flipped(uint32_t flags){
+
+	uint32_t dirty(index(flags, Dirty)), pending(index(flags, PendingLatest));
+	if(flags & NewLatest){
+		// the pending value becomes the previous one, the old previous one is free to write
+		uint32_t free(index(flags, PendingPrev));
+		return with(with(with(flags, PendingPrev, pending), PendingLatest, dirty), Dirty, free) | HasPrev;
+	}
+	// the reader took the last value, it will be the previous one when it takes this
+	return with(with(flags, PendingLatest, dirty), Dirty, pending) | NewLatest;
+}
+
+template <typename T>
+uint32_t SnapshotPairBuffer<T>::taken(uint32_t flags){
+
+	uint32_t pending(index(flags, PendingLatest)), latest(index(flags, Latest)), previous(index(flags, Previous));
+	uint32_t next(with(flags, Latest, pending) & ~(NewLatest | HasPrev));
+	if(flags & HasPrev) // both taken, the two held ones are free
+		return with(with(with(next, Previous, index(flags, PendingPrev)), PendingLatest, latest), PendingPrev, previous);
+	// the latest held one becomes the previous one
+	return with(with(next, Previous, latest), PendingLatest, previous);
+}
+
+template <typename T>
+T& SnapshotPairBuffer<T>::dirty(){
+
+	return buffer[index(flags.load(memory_order_acquire), Dirty)]; // dirty index
+}
+
+template <typename T>
+void SnapshotPairBuffer<T>::write(const T& newT){
+
+	dirty() = newT; // write into dirty index
+}
+
+template <typename T>
+void SnapshotPairBuffer<T>::flipWriter(){
+
+	uint32_t flagsNow(flags.load(memory_order_acquire));
+	uint32_t slot(index(flagsNow, Dirty)); // only the writer moves it
+	seq[slot] = ++written;
+	time[slot] = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+
+	while(!flags.compare_exchange_weak(flagsNow, flipped(flagsNow), memory_order_acq_rel, memory_order_acquire))
+		;
+}
+
+template <typename T>
+void SnapshotPairBuffer<T>::update(const T& newT){
+	write(newT); // write new value
+	flipWriter(); // publish it
+}
+
+template <typename T>
+bool SnapshotPairBuffer<T>::newSnap(){
+
+	uint32_t flagsNow(flags.load(memory_order_acquire));
+	while(flagsNow & NewLatest){ // otherwise nothing new, no need to swap
+		if(flags.compare_exchange_weak(flagsNow, taken(flagsNow), memory_order_acq_rel, memory_order_acquire))
+			return true;
+	}
+
+	return false;
+}
+
+template <typename T>
+const T& SnapshotPairBuffer<T>::latest() const{
+
+	return buffer[index(flags.load(memory_order_acquire), Latest)];
+}
+
+template <typename T>
+const T& SnapshotPairBuffer<T>::previous() const{
+
+	return buffer[index(flags.load(memory_order_acquire), Previous)];
+}
+
+template <typename T>
+uint64_t SnapshotPairBuffer<T>::latestTime() const{
+
+	return time[index(flags.load(memory_order_acquire), Latest)];
+}
+
+template <typename T>
+uint64_t SnapshotPairBuffer<T>::previousTime() const{
+
+	return time[index(flags.load(memory_order_acquire), Previous)];
+}
+
+template <typename T>
+uint64_t SnapshotPairBuffer<T>::latestSeq() const{
+
+	return seq[index(flags.load(memory_order_acquire), Latest)];
+}
+
+template <typename T>
+uint64_t SnapshotPairBuffer<T>::previousSeq() const{
+
+	return seq[index(flags.load(memory_order_acquire), Previous)];
+}
+
+#endif /* SNAPSHOTPAIRBUFFER_HXX_ */
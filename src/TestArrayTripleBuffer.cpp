@@ -0,0 +1,83 @@
+//============================================================================
+// Name        : TestArrayTripleBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : ArrayTripleBuffer test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "ArrayTripleBuffer.hxx"
+template class ArrayTripleBuffer<double>; // explicit instantiation
+
+using namespace std;
+
+int main() {
+
+	ArrayTripleBuffer<double> buffer(37, 1.0);
+
+	/* Test 1 */
+
+	assert(buffer.size() == 37); // <
+	assert(buffer.snap().size() == 37); // <
+	assert(buffer.snap()[36] == 1.0); // <
+	assert(reinterpret_cast<uintptr_t>(buffer.snap().data()) % TRIPLEBUFFER_CACHE_LINE_SIZE == 0); // <
+	assert(reinterpret_cast<uintptr_t>(buffer.dirty().data()) % TRIPLEBUFFER_CACHE_LINE_SIZE == 0); // <
+
+	/* Test 2 */
+
+	vector<double> prices(37, 2.0);
+	buffer.update(prices.data());
+
+	Span<const double> last(buffer.readLast());
+	assert(last[0] == 2.0); // <
+
+	/* Test 3 */
+
+	Span<double> dirty = buffer.dirty();
+	for(size_t i = 0; i < dirty.size(); ++i)
+		dirty[i] = i;
+	buffer.flipWriter();
+
+	buffer.update(prices.data());
+	buffer.newSnap();
+
+	assert(buffer.snap()[5] == 2.0); // <
+
+	dirty = buffer.dirty();
+	for(double& price : dirty)
+		price = 3.0;
+	buffer.flipWriter();
+
+	buffer.newSnap();
+	assert(buffer.snap()[36] == 3.0); // <
+
+	return 1;
+}
@@ -0,0 +1,145 @@
+//============================================================================
+// Name        : TestBenchWorkload.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : BenchWorkload test class
+//============================================================================
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+#include "BenchWorkload.hxx"
+
+using namespace std;
+
+// whether building the schedule is rejected as invalid
+template <typename F>
+static bool refuses(F build){
+
+	try {
+		build();
+	}
+	catch(invalid_argument&){
+		return true;
+	}
+	return false;
+}
+
+int main() {
+
+	/* Test 1 */
+
+	vector<BenchWorkload::Arrival> steady(BenchWorkload::uniform(1000, 1e6));
+	assert(steady.size() == 1000 && steady[0].time == 0 && steady[999].time == 999000); // <
+
+	vector<BenchWorkload::Arrival> random(BenchWorkload::poisson(100000, 1e6));
+	double mean(random.back().time / 1e5);
+	assert(mean > 950 && mean < 1050); // < mean gap 1 us
+	for(size_t i = 1; i < random.size(); ++i)
+		assert(random[i].time >= random[i - 1].time); // <
+
+	vector<BenchWorkload::Arrival> bursts(BenchWorkload::bursty(30, 10, 100, 100000));
+	assert(bursts[9].time == 900 && bursts[10].time == 900 + 100000); // <
+
+	assert(refuses([](){ BenchWorkload::uniform(10, 0); })); // <
+	assert(refuses([](){ BenchWorkload::uniform(10, -1); })); // <
+	assert(refuses([](){ BenchWorkload::poisson(10, 0); })); // <
+	assert(refuses([](){ BenchWorkload::poisson(10, nan("")); })); // <
+	assert(refuses([](){ BenchWorkload::bursty(10, 0, 100, 1000); })); // < no burst size
+
+	/* Test 2 */
+
+	BenchWorkload::PayloadSizes::uniform(16, 64).apply(random);
+	for(size_t i = 0; i < random.size(); ++i)
+		assert(random[i].bytes >= 16 && random[i].bytes <= 64); // <
+
+	BenchWorkload::PayloadSizes::bimodal(32, 4096, 0.1).apply(random);
+	size_t large(0);
+	for(size_t i = 0; i < random.size(); ++i)
+		large += random[i].bytes == 4096;
+	assert(large > 9000 && large < 11000); // <
+
+	BenchWorkload::PayloadSizes::lognormal(256, 1, 4096).apply(random);
+	for(size_t i = 0; i < random.size(); ++i)
+		assert(random[i].bytes <= 4096); // <
+
+	BenchWorkload::PayloadSizes::fixed(0).apply(random);
+	assert(random[0].bytes == 0 && random.back().bytes == 0); // < the other distributions are not built
+
+	bool rejected(false);
+	try {
+		BenchWorkload::PayloadSizes::uniform(64, 16);
+	}
+	catch(invalid_argument&){
+		rejected = true;
+	}
+	assert(rejected); // <
+
+	/* Test 3 */
+
+	char path[] = "/tmp/triplebuffer-traceXXXXXX";
+	int fd(mkstemp(path));
+	assert(fd >= 0); // <
+	close(fd);
+
+	BenchWorkload::PayloadSizes::fixed(100).apply(bursts);
+	for(size_t i = 0; i < bursts.size(); ++i)
+		bursts[i].time += 5000; // recorded times need not start at 0
+	BenchWorkload::writeTrace(path, bursts);
+	vector<BenchWorkload::Arrival> replay(BenchWorkload::trace(path));
+	unlink(path);
+	assert(replay.size() == 30 && replay[0].time == 0 && replay[10].time == 100900 && replay[29].bytes == 100); // <
+
+	swap(bursts[0], bursts[5]); // out of order capture
+	bursts[5].bytes = 7;
+	BenchWorkload::writeTrace(path, bursts);
+	replay = BenchWorkload::trace(path);
+	unlink(path);
+	assert(replay[0].time == 0 && replay[0].bytes == 7 && replay[29].time == 202700); // < sorted, relative to the earliest
+
+	/* Test 4 */
+
+	BenchWorkload::Processing work(BenchWorkload::Processing::exponential(1000));
+	uint64_t total(0);
+	for(int i = 0; i < 10000; ++i)
+		total += work.next();
+	assert(total > 9000000 && total < 11000000); // <
+
+	uint64_t cpu(BenchWorkload::threadCpuNs());
+	BenchWorkload::Processing::spin(2000000);
+	assert(BenchWorkload::threadCpuNs() - cpu >= 1000000); // < busy, not sleeping
+
+	return 1;
+}
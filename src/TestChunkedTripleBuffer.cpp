@@ -0,0 +1,176 @@
+//============================================================================
+// Name        : TestChunkedTripleBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : ChunkedTripleBuffer test class
+//============================================================================
+
+#include <atomic>
+#include <cassert>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ChunkedTripleBuffer.hxx"
+template class ChunkedTripleBuffer<int>; // explicit instantiation
+
+using namespace std;
+
+int main() {
+
+	ChunkedTripleBuffer<int> buffer(10, 4);
+	vector<int> chunk(4);
+
+	/* Test 1 */
+
+	assert(buffer.chunks() == 3); // <
+	assert(buffer.inFlightSeq() == 1); // <
+	assert(buffer.snapSeq() == 0); // <
+
+	bool refused(false);
+	try {
+		ChunkedTripleBuffer<int> unchunked(10, 0);
+	}
+	catch(invalid_argument&){
+		refused = true;
+	}
+	assert(refused); // <
+
+	int outside(0);
+	try {
+		buffer.beginChunk(3);
+	}
+	catch(out_of_range&){
+		++outside;
+	}
+	try {
+		buffer.endChunk(3);
+	}
+	catch(out_of_range&){
+		++outside;
+	}
+	try {
+		buffer.readChunk(1, 3, chunk.data());
+	}
+	catch(out_of_range&){
+		++outside;
+	}
+	assert(outside == 3); // <
+
+	/* Test 2 */
+
+	Span<int> part = buffer.beginChunk(0);
+	for(int& v : part)
+		v = 1;
+	buffer.endChunk(0);
+
+	bool copied(buffer.readChunk(1, 0, chunk.data()));
+	assert(copied); // <
+	assert(chunk[3] == 1); // <
+	copied = buffer.readChunk(1, 1, chunk.data());
+	assert(!copied); // <
+
+	part = buffer.beginChunk(1);
+	copied = buffer.readChunk(1, 1, chunk.data());
+	assert(!copied); // <
+	for(int& v : part)
+		v = 1;
+	buffer.endChunk(1);
+
+	part = buffer.beginChunk(2);
+	assert(part.size() == 2); // <
+	for(int& v : part)
+		v = 1;
+	buffer.endChunk(2);
+
+	bool fresh(buffer.newSnap());
+	assert(!fresh); // <
+	buffer.flipWriter();
+	assert(buffer.inFlightSeq() == 2); // <
+
+	fresh = buffer.newSnap();
+	assert(fresh); // <
+	assert(buffer.snapSeq() == 1); // <
+	assert(buffer.snap()[9] == 1); // <
+	copied = buffer.readChunk(1, 2, chunk.data());
+	assert(copied); // <
+
+	/* Test 3 */
+
+	vector<int> values(10, 2);
+	buffer.update(values.data());
+	values.assign(10, 3);
+	buffer.update(values.data());
+
+	copied = buffer.readChunk(1, 0, chunk.data());
+	assert(copied); // < still the snap
+	copied = buffer.readChunk(2, 0, chunk.data());
+	assert(copied); // <
+	assert(chunk[0] == 2); // <
+
+	buffer.newSnap();
+	assert(buffer.snapSeq() == 3); // <
+	assert(buffer.snap()[0] == 3); // <
+
+	/* Test 4 */
+
+	ChunkedTripleBuffer<long> large(100000, 1000);
+	atomic<bool> done(false);
+
+	thread writer([&](){
+		for(long version = 1; !done.load(); ++version){
+			for(size_t c = 0; c < large.chunks(); ++c){
+				Span<long> part = large.beginChunk(c);
+				for(long& v : part)
+					v = version;
+				large.endChunk(c);
+			}
+			large.flipWriter();
+		}
+	});
+
+	vector<long> copy(1000);
+	for(int i = 0; i < 2000; ++i){
+		uint64_t version(large.inFlightSeq());
+		for(size_t c = 0; c < large.chunks(); ++c){
+			if(!large.readChunk(version, c, copy.data()))
+				continue;
+			for(long v : copy)
+				assert(v == (long)version); // <
+		}
+		if(large.newSnap()){
+			Span<const long> snap = large.snap();
+			assert(snap[0] == (long)large.snapSeq()); // <
+		}
+	}
+
+	done.store(true);
+	writer.join();
+
+	return 1;
+}
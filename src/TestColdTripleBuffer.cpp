@@ -0,0 +1,215 @@
+//============================================================================
+// Name        : TestColdTripleBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : ColdTripleBuffer test class
+//============================================================================
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ColdTripleBuffer.hxx"
+template class ColdTripleBuffer<int>; // explicit instantiation
+
+using namespace std;
+
+struct Book
+{
+	uint64_t version;
+	double levels[100000]; // mostly empty
+	char name[13];
+};
+
+static bool roundTrip(const vector<unsigned char>& data){
+
+	WordRunCodec codec;
+	vector<unsigned char> packed;
+	vector<unsigned char> unpacked(data.size() + 1, 0xff);
+	return codec.compress(data.data(), data.size(), packed) &&
+		   codec.decompress(packed.data(), packed.size(), unpacked.data(), data.size()) &&
+		   memcmp(unpacked.data(), data.data(), data.size()) == 0 && unpacked[data.size()] == 0xff &&
+		   !codec.decompress(packed.data(), packed.size(), unpacked.data(), data.size() + 8);
+}
+
+// WordRunCodec that can be told to fail unpacking
+struct FlakyCodec : WordRunCodec
+{
+	static bool failing;
+
+	bool decompress(const unsigned char* data, size_t size, unsigned char* out, size_t outSize){
+		return !failing && WordRunCodec::decompress(data, size, out, outSize);
+	}
+};
+
+bool FlakyCodec::failing(false);
+
+int main() {
+
+	/* Test 1 */
+
+	vector<unsigned char> data(1000);
+	assert(roundTrip(data)); // < zeros
+	for(size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<unsigned char>(i * 31 + (i >> 5));
+	assert(roundTrip(data)); // < literals
+	memset(&data[100], 7, 400);
+	data.resize(997);
+	assert(roundTrip(data)); // < mixed, with a tail
+	assert(roundTrip(vector<unsigned char>(5, 1))); // < tail only
+
+	WordRunCodec codec;
+	vector<unsigned char> packed;
+	vector<unsigned char> zeros(1 << 20);
+	bool compressed(codec.compress(zeros.data(), zeros.size(), packed));
+	assert(compressed && packed.size() == 12); // <
+
+	/* Test 2 */
+
+	ColdTripleBuffer<Book> buffer(chrono::nanoseconds(0));
+	size_t slotBytes(buffer.residentBytes() / 3);
+	assert(slotBytes >= sizeof(Book)); // <
+
+	Book& first = buffer.dirty();
+	first.version = 1;
+	first.levels[10] = 1.5;
+	strcpy(first.name, "first");
+	buffer.flipWriter();
+
+	size_t released(buffer.compact()); // latest not taken yet, only the dirty slot
+	assert(released > 0 && buffer.coldSlots() == 1); // <
+	assert(buffer.residentBytes() == 3 * slotBytes - released); // <
+	released = buffer.compact();
+	assert(released == 0); // < nothing more
+
+	const Book* snap(&buffer.readLast());
+	assert(snap->version == 1 && snap->levels[10] == 1.5); // <
+	released = buffer.compact();
+	assert(released > 0 && buffer.coldSlots() == 2); // < the stale clean slot too
+	snap = &buffer.readLast();
+	assert(snap->version == 1 && strcmp(snap->name, "first") == 0); // < reader unaffected
+
+	/* Test 3 */
+
+	Book& second = buffer.dirty(); // unpacked in place
+	assert(buffer.thaws() == 1 && buffer.coldSlots() == 1); // <
+	second.version = 2;
+	buffer.flipWriter();
+	snap = &buffer.readLast();
+	assert(snap->version == 2); // <
+	released = buffer.compact();
+	assert(released > 0 && buffer.coldSlots() == 2); // < the first value is packed now
+
+	buffer.flipWriter(); // republishes the packed initial slot
+	assert(buffer.thaws() == 2 && buffer.coldSlots() == 1); // <
+	snap = &buffer.readLast();
+	assert(snap->version == 0 && snap->name[0] == 0); // <
+
+	Book& again = buffer.dirty();
+	assert(buffer.thaws() == 3 && buffer.coldSlots() == 0); // <
+	assert(again.version == 1 && again.levels[10] == 1.5 && strcmp(again.name, "first") == 0); // < old contents back
+	buffer.flipWriter();
+
+	/* Test 4 */
+
+	ColdTripleBuffer<Book> slow(chrono::milliseconds(20));
+	Book book = Book();
+	book.version = 1;
+	slow.update(book);
+	released = slow.compact();
+	assert(released == 0); // < not idle yet
+	this_thread::sleep_for(chrono::milliseconds(30));
+	released = slow.compact();
+	assert(released > 0); // <
+	slow.update(book);
+	released = slow.compact();
+	assert(slow.thaws() == 1 && released == 0); // < busy again
+
+	/* Test 5 */
+
+	ColdTripleBuffer<Book> shared(chrono::nanoseconds(0));
+	atomic<bool> done(false);
+	thread housekeeper([&](){
+		while(!done.load())
+			shared.compact();
+	});
+	for(uint64_t version = 1; version <= 2000; ++version){
+		Book& dirty = shared.dirty();
+		dirty.version = version;
+		dirty.levels[version % 100000] = version;
+		shared.flipWriter();
+		const Book& snap = shared.readLast();
+		assert(snap.version == version && snap.levels[version % 100000] == version); // <
+	}
+	done.store(true);
+	housekeeper.join();
+
+	/* Test 6 */
+
+	ColdTripleBuffer<Book, FlakyCodec> flaky(chrono::nanoseconds(0));
+	flaky.update(book);
+	released = flaky.compact();
+	assert(released > 0); // <
+
+	FlakyCodec::failing = true;
+	bool failed(false);
+	try {
+		flaky.dirty();
+	}
+	catch(runtime_error&){
+		failed = true;
+	}
+	assert(failed); // <
+	released = flaky.compact(); // would spin forever if the lock had been kept
+	assert(released == 0 && flaky.coldSlots() == 1); // <
+
+	FlakyCodec::failing = false;
+	Book& restored = flaky.dirty();
+	assert(restored.version == 0 && flaky.coldSlots() == 0); // < the packed copy was kept
+	flaky.flipWriter();
+
+	/* Test 7 */
+
+	ColdTripleBuffer<Book> background(chrono::milliseconds(5));
+	background.update(book);
+	background.startCompactor(chrono::milliseconds(1));
+	for(int wait = 0; wait < 2000 && background.coldSlots() == 0; ++wait)
+		this_thread::sleep_for(chrono::milliseconds(1));
+	assert(background.coldSlots() > 0); // < packed without any call
+	background.update(book);
+	background.stopCompactor();
+	snap = &background.readLast();
+	assert(snap->version == 1); // <
+
+	return 1;
+}
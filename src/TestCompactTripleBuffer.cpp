@@ -0,0 +1,75 @@
+//============================================================================
+// Name        : TestCompactTripleBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : CompactTripleBuffer test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+
+#include "CompactTripleBuffer.hxx"
+template class CompactTripleBuffer<int>; // explicit instantiation
+
+using namespace std;
+
+struct Quote
+{
+	uint32_t bid;
+	uint32_t ask;
+	uint64_t seq;
+};
+
+int main() {
+
+	CompactTripleBuffer<int> buffer(0);
+
+	/* Test 1 */
+
+	assert(sizeof(CompactTripleBuffer<Quote>) == TRIPLEBUFFER_CACHE_LINE_SIZE); // <
+
+	/* Test 2 */
+
+	buffer.update(3);
+	int last(buffer.readLast());
+	assert(last == 3); // <
+
+	/* Test 3 */
+
+	buffer.update(4);
+	buffer.update(5);
+	buffer.newSnap();
+	buffer.update(6);
+	assert(buffer.snap() == 5); // <
+	last = buffer.readLast();
+	assert(last == 6); // <
+	last = buffer.readLast();
+	assert(last == 6); // <
+
+	return 1;
+}
@@ -0,0 +1,73 @@
+//============================================================================
+// Name        : TestCrc32c.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : Crc32c test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Crc32c.hxx"
+
+using namespace std;
+
+int main() {
+
+	/* Test 1 */
+
+	assert(Crc32c::compute("123456789", 9) == 0xe3069283); // < check value
+	assert(Crc32c::portable("123456789", 9) == 0xe3069283); // <
+	assert(Crc32c::compute("", 0) == 0); // <
+
+	unsigned char zeros[32] = {};
+	assert(Crc32c::compute(zeros, 32) == 0x8a9136aa); // < RFC 3720 B.4
+
+	/* Test 2 */
+
+	vector<unsigned char> data(10007);
+	for(size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<unsigned char>(i * 131 + (i >> 7));
+
+	uint32_t whole(Crc32c::compute(data.data(), data.size()));
+	assert(whole == Crc32c::portable(data.data(), data.size())); // < hardware and tables agree
+
+	for(size_t split = 0; split < 40; split += 3){
+		uint32_t first(Crc32c::compute(data.data(), split));
+		assert(Crc32c::compute(data.data() + split, data.size() - split, first) == whole); // < extends
+	}
+
+	/* Test 3 */
+
+	data[5000] ^= 1;
+	assert(Crc32c::compute(data.data(), data.size()) != whole); // <
+
+	return 1;
+}
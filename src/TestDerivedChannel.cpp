@@ -0,0 +1,108 @@
+//============================================================================
+// Name        : TestDerivedChannel.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : DerivedChannel test class
+//============================================================================
+
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "DerivedChannel.hxx"
+template class DerivedChannel<int, long>; // explicit instantiation
+
+using namespace std;
+
+struct Book
+{
+	int depth[16];
+};
+
+int main() {
+
+	TripleBuffer<Book> buffer;
+	atomic<int> computed(0);
+
+	shared_ptr<DerivedChannel<Book, long> > total = derive(buffer, [&](const Book& book){
+		computed++;
+		long sum(0);
+		for(int d : book.depth)
+			sum += d;
+		return sum;
+	});
+
+	/* Test 1 */
+
+	uint64_t seq;
+	shared_ptr<const long> latest = total->readLast(seq);
+	assert(*latest == 0); // <
+	assert(seq == 0); // <
+	latest = total->readLast();
+	assert(*latest == 0); // <
+	assert(computed == 1); // <
+
+	/* Test 2 */
+
+	Book book = Book();
+	for(int v = 1; v <= 3; ++v){
+		book.depth[0] = v;
+		buffer.update(book);
+	}
+
+	latest = total->readLast(seq);
+	assert(*latest == 3); // <
+	assert(seq == 3); // <
+	assert(computed == 2); // <
+
+	shared_ptr<const long> again = total->readLast();
+	assert(again == latest); // <
+	assert(computed == 2); // <
+
+	/* Test 3 */
+
+	book.depth[1] = 10;
+	buffer.update(book);
+
+	vector<thread> readers;
+	for(int r = 0; r < 4; ++r)
+		readers.push_back(thread([&](){
+			shared_ptr<const long> seen(total->readLast());
+			assert(*seen == 13 || *seen == 3); // < the previous result while another reader computes
+		}));
+	for(thread& t : readers)
+		t.join();
+
+	latest = total->readLast(seq);
+	assert(*latest == 13); // <
+	assert(seq == 4); // <
+	assert(computed == 3); // <
+
+	return 1;
+}
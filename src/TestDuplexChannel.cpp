@@ -0,0 +1,125 @@
+//============================================================================
+// Name        : TestDuplexChannel.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : DuplexChannel test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <thread>
+
+#include "DuplexChannel.hxx"
+template class DuplexChannel<int, double>; // explicit instantiation
+
+using namespace std;
+
+struct State
+{
+	uint64_t tick;
+	double position;
+};
+
+struct Command
+{
+	uint64_t tick; // state tick the command answers
+	double target;
+};
+
+int main() {
+
+	/* Test 1 */
+
+	DuplexChannel<int, double> channel;
+	DuplexEndpoint<int, double>& a = channel.first();
+	DuplexEndpoint<double, int>& b = channel.second();
+
+	bool freshA(a.newSnap());
+	bool freshB(b.newSnap());
+	assert(!freshA && !freshB); // <
+	assert(a.snap() == 0 && b.snap() == 0); // <
+
+	a.update(1);
+	a.update(2);
+	freshA = a.newSnap();
+	assert(!freshA); // < own direction does not count
+	int lastB(b.readLast());
+	assert(lastB == 2 && b.snapSeq() == 2); // <
+	assert(a.lastConsumed() == 2); // < acknowledged
+
+	b.update(0.5);
+	double lastA(a.readLast());
+	assert(lastA == 0.5 && b.lastConsumed() == 1); // <
+	assert(b.snap() == 2); // < untouched by the other direction
+
+	/* Test 2 */
+
+	for(int i = 3; i <= 10; ++i){
+		a.update(i);
+		b.update(i / 2.0);
+	}
+	lastB = b.readLast();
+	lastA = a.readLast();
+	assert(lastB == 10 && lastA == 5); // <
+	assert(a.lastPublished() == 10 && b.lastPublished() == 9); // <
+
+	/* Test 3 */
+
+	DuplexChannel<State, Command> loop;
+	const uint64_t ticks(20000);
+
+	thread controller([&](){
+		DuplexEndpoint<Command, State>& side = loop.second();
+		unsigned long spins(0);
+		for(uint64_t tick = 1; tick <= ticks; ++tick){
+			while(side.snap().tick < tick){
+				if(!side.newSnap())
+					TripleBufferFlags::backoff(spins);
+			}
+			Command command = { side.snap().tick, side.snap().position + 1 };
+			side.update(command);
+		}
+	});
+
+	DuplexEndpoint<State, Command>& plant = loop.first();
+	unsigned long spins(0);
+	for(uint64_t tick = 1; tick <= ticks; ++tick){
+		State state = { tick, static_cast<double>(tick) };
+		plant.update(state);
+		while(plant.snap().tick < tick){
+			if(!plant.newSnap())
+				TripleBufferFlags::backoff(spins);
+		}
+		assert(plant.snap().target == tick + 1); // < answers this tick
+	}
+	controller.join();
+
+	assert(plant.lastConsumed() == ticks); // <
+
+	return 1;
+}
@@ -0,0 +1,123 @@
+//============================================================================
+// Name        : TestEncodedTripleBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : EncodedTripleBuffer test class
+//============================================================================
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EncodedTripleBuffer.hxx"
+
+using namespace std;
+
+struct Quote
+{
+	long seq;
+	double price;
+};
+
+// "seq price" as text, like a feed would send it
+struct TextCodec
+{
+	string text; // scratch, reused by each side
+
+	void decode(const unsigned char* data, size_t size, Quote& quote){
+		text.assign(reinterpret_cast<const char*>(data), size);
+		char* end;
+		quote.seq = strtol(text.c_str(), &end, 10);
+		quote.price = strtod(end, nullptr);
+	}
+
+	void encode(const Quote& quote, vector<unsigned char>& data){
+		text.resize(64);
+		int size(snprintf(&text[0], text.size(), "%ld %g", quote.seq, quote.price));
+		data.insert(data.end(), text.begin(), text.begin() + size);
+	}
+};
+
+template class EncodedTripleBuffer<Quote, TextCodec>; // explicit instantiation
+
+int main() {
+
+	EncodedTripleBuffer<Quote, TextCodec> buffer;
+
+	/* Test 1 */
+
+	assert(buffer.snap().seq == 0 && buffer.decodes() == 0); // < initial value, nothing to decode
+
+	buffer.publish("1 99.5", 6);
+	bool taken(buffer.newSnap());
+	assert(taken); // <
+	assert(buffer.decodes() == 0); // < not read yet
+	assert(buffer.snap().seq == 1 && buffer.snap().price == 99.5); // <
+	assert(buffer.decodes() == 1); // < once per version
+
+	/* Test 2 */
+
+	for(long seq = 2; seq <= 100; ++seq){
+		Quote quote = { seq, 100.0 + seq };
+		buffer.update(quote);
+	}
+	const Quote* quote(&buffer.readLast());
+	assert(quote->seq == 100 && quote->price == 200); // <
+	assert(buffer.decodes() == 2); // < the conflated ones were never decoded
+	assert(string((const char*)buffer.snapData(), buffer.snapSize()) == "100 200"); // <
+
+	/* Test 3 */
+
+	string large(200, ' ');
+	large.replace(0, 8, "101 50.5");
+	buffer.publish(large.data(), large.size()); // out-of-line slot block
+	quote = &buffer.readLast();
+	assert(quote->seq == 101 && buffer.decodes() == 3); // <
+
+	/* Test 4 */
+
+	thread writer([&](){
+		for(long seq = 102; seq <= 20000; ++seq){
+			Quote quote = { seq, seq * 0.5 };
+			buffer.update(quote);
+		}
+	});
+	long last(101);
+	while(last != 20000){
+		const Quote& quote = buffer.readLast();
+		assert(quote.seq >= last && quote.price == quote.seq * 0.5); // <
+		last = quote.seq;
+	}
+	writer.join();
+
+	return 1;
+}
@@ -0,0 +1,147 @@
+//============================================================================
+// Name        : TestEventTimeCell.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : EventTimeCell test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "EventTimeCell.hxx"
+template class EventTimeCell<int, 2>; // explicit instantiation
+
+using namespace std;
+
+struct Reading
+{
+	uint64_t stamp;
+	uint64_t producer;
+	uint64_t check; // stamp ^ producer, to catch torn values
+};
+
+int main() {
+
+	/* Test 1 */
+
+	EventTimeCell<int, 2> cell;
+	EventTimeCell<int, 2>::Producer first(cell.producer());
+	EventTimeCell<int, 2>::Producer second(cell.producer());
+
+	bool full(false);
+	try {
+		cell.producer();
+	}
+	catch(runtime_error&){
+		full = true;
+	}
+	assert(full); // <
+
+	bool published(first.publish(10, 100));
+	assert(published); // <
+	published = second.publish(5, 50);
+	assert(!published); // < older than the pending one
+	int value(cell.readLast());
+	assert(value == 100 && cell.snapStamp() == 10); // <
+
+	published = second.publish(7, 70);
+	assert(!published); // < older than the consumed one
+	published = second.publish(10, 70);
+	assert(!published); // < not newer either
+	bool taken(cell.newSnap());
+	assert(!taken); // <
+
+	published = second.publish(12, 120);
+	assert(published); // <
+	published = first.publish(11, 110);
+	assert(!published); // <
+	published = first.publish(15, 150);
+	assert(published); // < conflates 12
+	value = cell.readLast();
+	assert(value == 150 && cell.snapStamp() == 15); // <
+
+	/* Test 2 */
+
+	for(uint64_t stamp = 16; stamp < 100; ++stamp){
+		published = (stamp % 2 ? first : second).publish(stamp, static_cast<int>(stamp));
+		assert(published); // < slots keep rotating
+	}
+	value = cell.readLast();
+	assert(value == 99); // <
+
+	EventTimeCell<int, 2>::Producer moved(std::move(second));
+	bool orphaned(false);
+	try {
+		second.publish(100, 1000);
+	}
+	catch(logic_error&){
+		orphaned = true;
+	}
+	assert(orphaned); // < the moved-from handle no longer owns a slot
+	published = moved.publish(100, 1000);
+	value = cell.readLast();
+	assert(published && value == 1000); // <
+
+	/* Test 3 */
+
+	EventTimeCell<Reading, 4> readings;
+	const uint64_t perProducer(20000);
+	vector<thread> threads;
+	for(uint64_t p = 0; p < 4; ++p){
+		threads.push_back(thread([&readings, p, perProducer](){
+			EventTimeCell<Reading, 4>::Producer producer(readings.producer());
+			for(uint64_t i = 1; i <= perProducer; ++i){
+				uint64_t stamp(i * 4 + ((p + i) % 4)); // interleaved and reordered across producers
+				Reading& reading = producer.dirty();
+				reading.stamp = stamp;
+				reading.producer = p;
+				reading.check = stamp ^ p;
+				producer.flip(stamp);
+			}
+		}));
+	}
+
+	uint64_t last(0);
+	const uint64_t newest(perProducer * 4 + 3);
+	while(last != newest){
+		if(!readings.newSnap())
+			continue;
+		const Reading& reading = readings.snap();
+		assert(reading.stamp > last); // < never regresses
+		assert(reading.stamp == readings.snapStamp() && reading.check == (reading.stamp ^ reading.producer)); // <
+		last = reading.stamp;
+	}
+	for(size_t t = 0; t < threads.size(); ++t)
+		threads[t].join();
+
+	return 1;
+}
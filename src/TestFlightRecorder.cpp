@@ -0,0 +1,140 @@
+//============================================================================
+// Name        : TestFlightRecorder.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : FlightRecorder test class
+//============================================================================
+
+#include <cassert>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "TripleBuffer.hxx"
+
+using namespace std;
+
+static FlightRecorder* crashLog;
+
+static void onCrash(int){
+	crashLog->dump(STDOUT_FILENO);
+	_exit(3);
+}
+
+static string readAll(int fd){
+	string text;
+	char chunk[4096];
+	ssize_t size;
+	while((size = read(fd, chunk, sizeof(chunk))) > 0)
+		text.append(chunk, size);
+	return text;
+}
+
+int main() {
+
+	/* Test 1 */
+
+	FlightRecorder log("test", 6);
+	assert(log.recorded() == 0 && log.events().empty()); // <
+
+	for(uint64_t seq = 1; seq <= 20; ++seq)
+		log.record(FlightRecorder::Flip, seq, seq == 20 ? 1000 : 0);
+
+	vector<FlightRecorder::Event> events(log.events());
+	assert(log.recorded() == 20); // <
+	assert(events.size() == 8); // < capacity rounded up to 8
+	assert(events.front().seq == 13 && events.back().seq == 20); // < oldest first
+	assert(events.back().number == 19 && events.back().retries == 255); // <
+	assert(events.back().thread == FlightRecorder::threadId()); // <
+	assert(events.front().time <= events.back().time); // <
+
+	/* Test 2 */
+
+	int pipes[2];
+	int piped(pipe(pipes));
+	assert(piped == 0); // <
+	log.dump(pipes[1]);
+	close(pipes[1]);
+	string text(readAll(pipes[0]));
+	close(pipes[0]);
+	assert(text.find("flight recorder test: 8 of 20 events\n") == 0); // <
+	assert(text.find("19 flip seq 20 ") != string::npos); // <
+	assert(text.find("seq 12 ") == string::npos); // < overwritten
+
+	/* Test 3 */
+
+	TripleBuffer<int> buffer(0);
+	FlightRecorder writerLog("writer", 1 << 10), readerLog("reader", 1 << 10);
+	buffer.recordWriter(&writerLog);
+	buffer.recordReader(&readerLog);
+
+	thread writer([&](){
+		for(int i = 1; i <= 100000; ++i)
+			buffer.update(i);
+	});
+	while(buffer.snap() != 100000)
+		buffer.newSnap();
+	writer.join();
+
+	assert(writerLog.recorded() == 100000); // <
+	events = writerLog.events();
+	assert(events.size() == 1 << 10 && events.back().seq == 100000); // <
+	events = readerLog.events();
+	for(size_t i = 1; i < events.size(); ++i)
+		assert(events[i].seq > events[i - 1].seq); // < snaps never go back
+
+	/* Test 4 */
+
+	piped = pipe(pipes);
+	assert(piped == 0); // <
+	pid_t child(fork());
+	if(child == 0){
+		dup2(pipes[1], STDOUT_FILENO);
+		crashLog = &writerLog;
+		signal(SIGSEGV, onCrash);
+		raise(SIGSEGV);
+		_exit(0);
+	}
+	close(pipes[1]);
+	text = readAll(pipes[0]);
+	close(pipes[0]);
+
+	int status;
+	pid_t reaped(waitpid(child, &status, 0));
+	assert(reaped == child); // <
+	assert(WIFEXITED(status) && WEXITSTATUS(status) == 3); // <
+	assert(text.find("flight recorder writer: 1024 of 100000 events\n") == 0); // <
+	assert(text.find(" flip seq 100000 ") != string::npos); // <
+
+	return 1;
+}
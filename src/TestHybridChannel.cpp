@@ -0,0 +1,139 @@
+//============================================================================
+// Name        : TestHybridChannel.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : HybridChannel test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "HybridChannel.hxx"
+template class HybridChannel<int, int, 4>; // explicit instantiation
+
+using namespace std;
+
+struct Book
+{
+	uint64_t version;
+	uint64_t trades; // trades applied to this state
+};
+
+struct Trade
+{
+	uint64_t id;
+	uint64_t version; // book version the trade happened at
+};
+
+int main() {
+
+	/* Test 1 */
+
+	HybridChannel<int, int, 4> channel;
+	vector<int> events;
+	auto collect = [&](const int& e){ events.push_back(e); };
+
+	bool polled(channel.poll(collect));
+	assert(!polled); // < nothing yet
+
+	channel.update(1);
+	channel.pushEvent(10);
+	channel.update(2);
+	channel.update(3);
+	channel.pushEvent(30);
+
+	polled = channel.poll(collect);
+	assert(polled); // <
+	assert(channel.snap() == 3); // < conflated
+	assert(events.size() == 2 && events[0] == 10 && events[1] == 30); // < lossless
+
+	/* Test 2 */
+
+	bool pushed(true);
+	for(int e = 1; e <= 4; ++e)
+		pushed = channel.pushEvent(e) && pushed;
+	assert(pushed); // <
+	pushed = channel.pushEvent(5);
+	assert(!pushed); // < full
+	assert(channel.pendingEvents() == 4); // <
+	events.clear();
+	polled = channel.poll(collect);
+	assert(polled && events.size() == 4); // <
+	pushed = channel.pushEvent(5);
+	assert(pushed); // <
+
+	/* Test 3 */
+
+	HybridChannel<int, int, 4> ordered;
+	ordered.update(1);
+	ordered.pushEvent(1);
+	ordered.poll(collect);
+
+	ordered.dirty() = 2; // event happens on a value the reader has not taken yet
+	ordered.flipWriter();
+	ordered.pushEvent(2);
+	events.clear();
+	ordered.poll(collect);
+	assert(events.size() == 1 && ordered.snap() == 2); // <
+
+	/* Test 4 */
+
+	HybridChannel<Book, Trade, 64> feed;
+	const uint64_t trades(20000);
+
+	thread writer([&](){
+		Book book = { 0, 0 };
+		for(uint64_t id = 1; id <= trades; ++id){
+			++book.version;
+			++book.trades;
+			feed.update(book);
+			Trade trade = { id, book.version };
+			while(!feed.pushEvent(trade))
+				this_thread::yield();
+			if(id % 3 == 0){ // quotes in between, conflatable
+				++book.version;
+				feed.update(book);
+			}
+		}
+	});
+
+	uint64_t next(1);
+	while(next <= trades){
+		feed.poll([&](const Trade& trade){
+			assert(trade.id == next); // < none lost, in order
+			assert(feed.snap().version >= trade.version); // < state at least as recent as the event
+			assert(feed.snap().trades >= trade.id); // <
+			++next;
+		});
+	}
+	writer.join();
+
+	return 1;
+}
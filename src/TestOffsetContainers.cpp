@@ -0,0 +1,137 @@
+//============================================================================
+// Name        : TestOffsetContainers.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : OffsetContainers test class
+//============================================================================
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "OffsetContainers.hxx"
+#include "TripleBuffer.hxx"
+template class OffsetVector<int>; // explicit instantiation
+
+using namespace std;
+
+struct Payload
+{
+	SlotArena<4096> arena;
+	OffsetString name;
+	OffsetVector<int> ids;
+	OffsetMap<OffsetString, double> prices;
+};
+
+static void build(Payload& payload, int version){
+
+	payload.arena.reset();
+	payload.name.assign(payload.arena, version % 2 ? "odd" : "even");
+
+	payload.ids.clear();
+	for(int i = 0; i < 100; ++i)
+		payload.ids.push_back(payload.arena, version + i);
+
+	payload.prices.clear();
+	const char* symbols[] = { "MSFT", "AAPL", "IBM" };
+	for(const char* symbol : symbols){
+		OffsetString key;
+		key.assign(payload.arena, symbol);
+		payload.prices.insert(payload.arena, key, version + symbol[0] / 100.0);
+	}
+}
+
+static void check(const Payload& payload, int version){
+
+	assert(payload.name == (version % 2 ? "odd" : "even")); // <
+	assert(payload.ids.size() == 100); // <
+	assert(payload.ids[99] == version + 99); // <
+	assert(payload.prices.size() == 3); // <
+	assert(strcmp(payload.prices.begin()->key.c_str(), "AAPL") == 0); // <
+	assert(*payload.prices.find("IBM") == version + 'I' / 100.0); // <
+	assert(payload.prices.find("GOOG") == nullptr); // <
+}
+
+int main() {
+
+	/* Test 1 */
+
+	SlotArena<64> arena;
+	OffsetVector<int> small;
+	small.push_back(arena, 1);
+	assert(arena.size() == 4 * sizeof(int)); // <
+
+	bool full(false);
+	try {
+		for(int i = 0; i < 64; ++i)
+			small.push_back(arena, i);
+	}
+	catch(bad_alloc&){
+		full = true;
+	}
+	assert(full); // <
+
+	SlotArena<64> text;
+	OffsetString word;
+	word.assign(text, "sixteen chars ok");
+	assert(text.size() == 17); // <
+	assert(word == "sixteen chars ok"); // <
+
+	bool refused(false);
+	try {
+		small.reserve(text, size_t(UINT32_MAX) + 1);
+	}
+	catch(length_error&){
+		refused = true;
+	}
+	assert(refused); // <
+	assert(text.size() == 17); // <
+
+	/* Test 2 */
+
+	unique_ptr<TripleBuffer<Payload> > buffer(new TripleBuffer<Payload>());
+
+	for(int version = 1; version <= 5; ++version){
+		build(buffer->dirty(), version);
+		buffer->flipWriter();
+		buffer->newSnap();
+		check(buffer->snapRef(), version);
+	}
+
+	/* Test 3 */
+
+	unique_ptr<Payload> moved(new Payload());
+	memcpy(static_cast<void*>(moved.get()), &buffer->snapRef(), sizeof(Payload)); // as if mapped elsewhere
+	build(buffer->dirty(), 6);
+	buffer->flipWriter();
+	buffer->newSnap();
+	check(*moved, 5);
+
+	return 1;
+}
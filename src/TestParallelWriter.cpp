@@ -0,0 +1,117 @@
+//============================================================================
+// Name        : TestParallelWriter.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : ParallelWriter test class
+//============================================================================
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "ArrayTripleBuffer.hxx"
+#include "ParallelWriter.hxx"
+#include "TripleBuffer.hxx"
+template class ParallelWriter<ArrayTripleBuffer<int> >; // explicit instantiation
+
+using namespace std;
+
+struct Snapshot
+{
+	int values[64];
+};
+
+int main() {
+
+	const unsigned workers(4);
+
+	/* Test 1 */
+
+	size_t begin, end;
+	ParallelWriter<TripleBuffer<int> >::chunk(10, 0, 4, begin, end);
+	assert(begin == 0 && end == 3); // <
+	ParallelWriter<TripleBuffer<int> >::chunk(10, 3, 4, begin, end);
+	assert(begin == 8 && end == 10); // <
+
+	/* Test 2 */
+
+	ArrayTripleBuffer<int> array(1000, 0);
+	ParallelWriter<ArrayTripleBuffer<int> > arrayWriter(array, workers);
+
+	vector<thread> team;
+	for(unsigned w = 0; w < workers; ++w){
+		team.push_back(thread([&, w](){
+			for(int round = 1; round <= 100; ++round){
+				Span<int> slot = arrayWriter.dirty();
+				size_t begin, end;
+				ParallelWriter<ArrayTripleBuffer<int> >::chunk(slot.size(), w, workers, begin, end);
+				for(size_t i = begin; i < end; ++i)
+					slot[i] = round;
+				arrayWriter.publish();
+			}
+		}));
+	}
+
+	int last(0);
+	while(last != 100){
+		if(!array.newSnap())
+			continue;
+		Span<const int> snap = array.snap();
+		for(size_t i = 0; i < snap.size(); ++i)
+			assert(snap[i] == snap[0]); // <
+		assert(snap[0] > last); // <
+		last = snap[0];
+	}
+
+	for(thread& t : team)
+		t.join();
+	team.clear();
+
+	/* Test 3 */
+
+	TripleBuffer<Snapshot> buffer;
+	ParallelWriter<TripleBuffer<Snapshot> > writer(buffer, workers);
+
+	for(unsigned w = 0; w < workers; ++w){
+		team.push_back(thread([&, w](){
+			size_t begin, end;
+			ParallelWriter<TripleBuffer<Snapshot> >::chunk(64, w, workers, begin, end);
+			for(size_t i = begin; i < end; ++i)
+				writer.dirty().values[i] = 7;
+			writer.publish();
+		}));
+	}
+	for(thread& t : team)
+		t.join();
+
+	buffer.newSnap();
+	for(int i = 0; i < 64; ++i)
+		assert(buffer.snap().values[i] == 7); // <
+
+	return 1;
+}
@@ -0,0 +1,184 @@
+//============================================================================
+// Name        : TestPersistentTripleBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : PersistentTripleBuffer test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "PersistentTripleBuffer.hxx"
+template class PersistentTripleBuffer<int>; // explicit instantiation
+
+using namespace std;
+
+struct Prices
+{
+	uint64_t version;
+	double values[1000];
+};
+
+static Prices prices(uint64_t version){
+
+	Prices value;
+	value.version = version;
+	for(int i = 0; i < 1000; ++i)
+		value.values[i] = version;
+	return value;
+}
+
+int main() {
+
+	char path[] = "/tmp/TestPersistentTripleBufferXXXXXX";
+	int temporary(mkstemp(path));
+	assert(temporary >= 0); // <
+	close(temporary);
+	unlink(path); // let the buffer create it
+
+	/* Test 1 */
+
+	{
+		PersistentTripleBuffer<Prices> buffer(path);
+		assert(!buffer.recovered() && buffer.integrity()); // <
+		assert(buffer.snap().version == 0); // <
+		for(uint64_t version = 1; version <= 3; ++version)
+			buffer.update(prices(version));
+		buffer.sync();
+	}
+
+	{
+		PersistentTripleBuffer<Prices> buffer(path);
+		assert(buffer.recovered()); // <
+		assert(buffer.snap().version == 3 && buffer.snapSeq() == 3 && buffer.verify()); // < readable at once
+		bool taken(buffer.newSnap());
+		assert(!taken); // <
+		assert(buffer.snap().values[999] == 3); // <
+	}
+
+	/* Test 2 */
+
+	{
+		PersistentTripleBuffer<Prices> buffer(path);
+		Prices& dirty = buffer.dirty(); // died half way through an update
+		dirty.version = 4;
+		dirty.values[0] = 4;
+	}
+
+	{
+		PersistentTripleBuffer<Prices> buffer(path);
+		assert(buffer.recovered() && buffer.snap().version == 3); // <
+		buffer.update(prices(4));
+		uint64_t version(buffer.readLast().version);
+		assert(version == 4 && buffer.snapSeq() == 4 && buffer.verify()); // < numbering goes on
+	}
+
+	/* Test 3 */
+
+	int file(open(path, O_RDWR));
+	assert(file >= 0); // <
+	size_t slotBytes(SharedMemory::roundToPage(sizeof(Prices)));
+	bool corrupted(false);
+	for(int i = 0; i < 3; ++i){ // a page of the newest slot never reached the disk
+		off_t offset(SharedMemory::pageSize() + i * slotBytes);
+		uint64_t version;
+		ssize_t bytes(pread(file, &version, sizeof(version), offset));
+		assert(bytes == sizeof(version)); // <
+		if(version == 4){
+			double garbage(-1);
+			bytes = pwrite(file, &garbage, sizeof(garbage), offset + 8 + 900 * sizeof(double));
+			assert(bytes == sizeof(garbage)); // <
+			corrupted = true;
+		}
+	}
+	assert(corrupted); // <
+	close(file);
+
+	{
+		PersistentTripleBuffer<Prices> buffer(path);
+		assert(buffer.recovered() && buffer.snap().version == 3 && buffer.verify()); // < previous good slot
+		buffer.update(prices(5));
+		uint64_t version(buffer.readLast().version);
+		assert(version == 5 && buffer.snapSeq() == 5); // <
+	}
+
+	/* Test 4 */
+
+	bool mismatch(false);
+	try {
+		PersistentTripleBuffer<int> wrong(path);
+	}
+	catch(runtime_error&){
+		mismatch = true;
+	}
+	assert(mismatch); // <
+
+	/* Test 5 */
+
+	{
+		PersistentTripleBuffer<Prices> writer(path);
+		bool locked(false);
+		try {
+			PersistentTripleBuffer<Prices> second(path);
+		}
+		catch(runtime_error&){
+			locked = true;
+		}
+		assert(locked); // < one writer at a time
+	}
+
+	/* Test 6 */
+
+	file = open(path, O_RDWR);
+	assert(file >= 0); // <
+	uint64_t magic(0);
+	ssize_t bytes(pwrite(file, &magic, sizeof(magic), 0)); // died while creating the file
+	assert(bytes == sizeof(magic)); // <
+	close(file);
+
+	{
+		PersistentTripleBuffer<Prices> buffer(path);
+		assert(!buffer.recovered() && buffer.snap().version == 0 && buffer.verify()); // < built again
+		buffer.update(prices(6));
+	}
+
+	{
+		PersistentTripleBuffer<Prices> buffer(path);
+		uint64_t version(buffer.readLast().version);
+		assert(buffer.recovered() && version == 6); // <
+	}
+
+	unlink(path);
+
+	return 1;
+}
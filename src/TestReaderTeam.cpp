@@ -0,0 +1,114 @@
+//============================================================================
+// Name        : TestReaderTeam.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : ReaderTeam test class
+//============================================================================
+
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "ReaderTeam.hxx"
+template class ReaderTeam<int>; // explicit instantiation
+
+using namespace std;
+
+struct Snapshot
+{
+	long values[128];
+};
+
+int main() {
+
+	/* Test 1 */
+
+	TripleBuffer<int> single(0);
+	ReaderTeam<int> alone(single, 1);
+
+	single.update(3);
+	bool fresh(alone.lead());
+	assert(fresh); // <
+	assert(alone.snap() == 3); // <
+	alone.release();
+	fresh = alone.lead();
+	assert(!fresh); // <
+	assert(alone.snap() == 3); // <
+	alone.release();
+	assert(alone.round() == 2); // <
+
+	/* Test 2 */
+
+	const unsigned members(4);
+	const unsigned long rounds(1000);
+
+	TripleBuffer<Snapshot> buffer;
+	ReaderTeam<Snapshot> team(buffer, members);
+	atomic<bool> done(false);
+
+	thread writer([&](){
+		for(long v = 1; !done.load(); ++v){
+			Snapshot& dirty = buffer.dirty();
+			for(int i = 0; i < 128; ++i)
+				dirty.values[i] = v;
+			buffer.flipWriter();
+			this_thread::yield();
+		}
+	});
+
+	vector<thread> readers;
+	for(unsigned m = 1; m < members; ++m){
+		readers.push_back(thread([&](){
+			unsigned long round(0);
+			while(round < rounds){
+				round = team.join(round);
+				const Snapshot& snap = team.snap();
+				for(int i = 0; i < 128; ++i)
+					assert(snap.values[i] == snap.values[0]); // <
+				team.release();
+			}
+		}));
+	}
+
+	long last(0);
+	for(unsigned long round = 0; round < rounds; ++round){
+		team.lead();
+		const Snapshot& snap = team.snap();
+		assert(snap.values[0] >= last); // <
+		last = snap.values[0];
+		team.release();
+	}
+
+	for(thread& t : readers)
+		t.join();
+	done.store(true);
+	writer.join();
+
+	return 1;
+}
@@ -0,0 +1,151 @@
+//============================================================================
+// Name        : TestReplicator.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : Replicator test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Replicator.hxx"
+template class Replicator<int>; // explicit instantiation
+
+using namespace std;
+
+struct Book
+{
+	uint64_t version;
+	int levels[1000];
+};
+
+int main() {
+
+	int sockets[2];
+	int paired(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+	assert(paired == 0); // <
+
+	TripleBuffer<Book> source;
+	TripleBuffer<Book> replica;
+	Replicator<Book> sender(source, sockets[0]);
+	ReplicaReceiver<Book> receiver(replica, sockets[1]);
+
+	Book book = Book();
+
+	/* Test 1 */
+
+	book.version = 1;
+	book.levels[999] = 7;
+	source.update(book);
+	bool sent(sender.replicateOnce());
+	assert(sent); // <
+	assert(sender.bytesSent() > sizeof(Book)); // < first one is whole
+
+	bool received(receiver.receiveOnce());
+	assert(received); // <
+	assert(receiver.lastSeq() == 1); // <
+	Book copy = replica.readLast();
+	assert(copy.levels[999] == 7); // <
+
+	/* Test 2 */
+
+	sent = sender.replicateOnce();
+	assert(!sent); // < nothing new
+
+	uint64_t before(sender.bytesSent());
+	book.levels[0] = 3;
+	source.update(book);
+	sent = sender.replicateOnce();
+	assert(sent); // <
+	assert(sender.bytesSent() - before < 2 * TRIPLEBUFFER_CACHE_LINE_SIZE + sizeof(ReplicaDelta)); // < two blocks
+
+	received = receiver.receiveOnce();
+	assert(received); // <
+	copy = replica.readLast();
+	assert(copy.levels[0] == 3 && copy.levels[999] == 7); // <
+
+	/* Test 3 */
+
+	for(int v = 3; v <= 5; ++v){
+		book.version = v;
+		book.levels[v] = v;
+		source.update(book);
+		sender.replicateOnce();
+	}
+
+	received = receiver.receiveOnce();
+	assert(received); // < applies the three waiting deltas at once
+	assert(receiver.lastSeq() == 5); // <
+	copy = replica.readLast();
+	assert(copy.version == 5 && copy.levels[3] == 3 && copy.levels[5] == 5); // <
+
+	/* Test 4 */
+
+	thread remote([&](){
+		while(receiver.receiveOnce())
+			;
+	});
+
+	for(int v = 6; v <= 1000; ++v){
+		book.version = v;
+		book.levels[v % 1000] = v;
+		source.update(book);
+		sender.replicateOnce();
+	}
+
+	shutdown(sockets[0], SHUT_WR);
+	remote.join();
+
+	copy = replica.readLast();
+	assert(copy.version == 1000); // <
+	assert(copy.levels[999] == 999 && copy.levels[0] == 1000); // <
+
+	/* Test 5 */
+
+	size_t sizes[] = { 0, size_t(UINT32_MAX) + 1 };
+	for(size_t blockSize : sizes){
+		bool refused(false);
+		try {
+			Replicator<Book> unusable(source, sockets[0], blockSize);
+		}
+		catch(invalid_argument&){
+			refused = true;
+		}
+		assert(refused); // <
+	}
+
+	close(sockets[0]);
+	close(sockets[1]);
+
+	return 1;
+}
@@ -0,0 +1,142 @@
+//============================================================================
+// Name        : TestSharedFanoutBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : SharedFanoutBuffer test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "SharedFanoutBuffer.hxx"
+template class SharedFanoutBuffer<int, 4>; // explicit instantiation
+
+using namespace std;
+
+struct Prices
+{
+	uint64_t version;
+	double values[512];
+};
+
+static int attachFd(int fd){
+	return fcntl(fd, F_DUPFD_CLOEXEC, 0); // each reader owns its own fd
+}
+
+int main() {
+
+	/* Test 1 */
+
+	SharedFanoutBuffer<int, 2> writer("fanout");
+	writer.update(1);
+
+	SharedFanoutBuffer<int, 2>* first = new SharedFanoutBuffer<int, 2>(attachFd(writer.fd()));
+	SharedFanoutBuffer<int, 2> second(attachFd(writer.fd()));
+	assert(writer.readers() == 2); // <
+	assert(first->snap() == 1 && second.snap() == 1); // <
+
+	bool full(false);
+	try {
+		SharedFanoutBuffer<int, 2> third(attachFd(writer.fd()));
+	}
+	catch(runtime_error&){
+		full = true;
+	}
+	assert(full); // <
+
+	for(int v = 2; v < 10; ++v)
+		writer.update(v); // always finds a free slot
+	assert(first->snap() == 1); // < still held
+	int firstLast(first->readLast());
+	int secondLast(second.readLast());
+	assert(firstLast == 9 && secondLast == 9); // <
+	assert(second.snapSeq() == 9); // <
+
+	delete first;
+	assert(writer.readers() == 1); // <
+
+	/* Test 2 */
+
+	pid_t crashed(fork());
+	if(crashed == 0){
+		SharedFanoutBuffer<int, 2> reader(attachFd(writer.fd()));
+		reader.readLast();
+		_exit(0); // no detach, as if it crashed
+	}
+	pid_t reaped(waitpid(crashed, nullptr, 0));
+	assert(reaped == crashed); // <
+	assert(writer.readers() == 2); // <
+
+	SharedFanoutBuffer<int, 2> replacement(attachFd(writer.fd())); // reclaims the dead reader's lease
+	assert(writer.readers() == 2); // <
+	unsigned reclaimed(writer.reclaimDeadReaders());
+	assert(reclaimed == 0); // <
+
+	/* Test 3 */
+
+	SharedFanoutBuffer<Prices, 8> prices("prices");
+	pid_t children[4];
+	for(int c = 0; c < 4; ++c){
+		children[c] = fork();
+		if(children[c] == 0){
+			SharedFanoutBuffer<Prices, 8> consumer(attachFd(prices.fd()));
+			while(consumer.snap().version != 200){
+				if(consumer.newSnap()){
+					const Prices& snap = consumer.snap();
+					for(int i = 0; i < 512; ++i)
+						if(snap.values[i] != snap.version)
+							_exit(1);
+				}
+			}
+			_exit(0);
+		}
+	}
+
+	for(uint64_t version = 1; version <= 200; ++version){
+		Prices& dirty = prices.dirty();
+		dirty.version = version;
+		for(int i = 0; i < 512; ++i)
+			dirty.values[i] = version;
+		prices.flipWriter();
+		usleep(100);
+	}
+
+	for(int c = 0; c < 4; ++c){
+		int status;
+		reaped = waitpid(children[c], &status, 0);
+		assert(reaped == children[c]); // <
+		assert(WIFEXITED(status) && WEXITSTATUS(status) == 0); // <
+	}
+
+	return 1;
+}
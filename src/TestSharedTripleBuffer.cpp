@@ -0,0 +1,161 @@
+//============================================================================
+// Name        : TestSharedTripleBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : SharedTripleBuffer test class
+//============================================================================
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "SharedTripleBuffer.hxx"
+template class SharedTripleBuffer<int>; // explicit instantiation
+
+using namespace std;
+
+struct Prices
+{
+	uint64_t version;
+	double values[1000];
+};
+
+int main() {
+
+	/* Test 1 */
+
+	int sockets[2];
+	int paired(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+	assert(paired == 0); // <
+
+	SharedTripleBuffer<int> writer("test");
+	SharedMemory::sendFd(sockets[0], writer.fd());
+	SharedTripleBuffer<int> reader(SharedMemory::receiveFd(sockets[1]));
+
+	assert(reader.snap() == 0); // <
+	writer.update(3);
+	int last(reader.readLast());
+	assert(last == 3); // <
+	assert(reader.snapSeq() == 1); // <
+
+	int truncated(ftruncate(writer.fd(), 0));
+	assert(truncated != 0); // < sealed
+
+	/* Test 2 */
+
+	bool mismatch(false);
+	SharedMemory::sendFd(sockets[0], writer.fd());
+	try {
+		SharedTripleBuffer<Prices> wrong(SharedMemory::receiveFd(sockets[1]));
+	}
+	catch(runtime_error&){
+		mismatch = true;
+	}
+	assert(mismatch); // <
+
+	/* Test 3 */
+
+	SharedTripleBuffer<Prices> prices("prices");
+	SharedMemory::sendFd(sockets[0], prices.fd());
+
+	pid_t child(fork());
+	if(child == 0){
+		SharedTripleBuffer<Prices> consumer(SharedMemory::receiveFd(sockets[1]));
+		while(consumer.snap().version != 100){
+			if(consumer.newSnap()){
+				const Prices& snap = consumer.snap();
+				for(int i = 0; i < 1000; ++i)
+					if(snap.values[i] != snap.version)
+						_exit(1);
+			}
+		}
+		_exit(0);
+	}
+
+	for(uint64_t version = 1; version <= 100; ++version){
+		Prices& dirty = prices.dirty();
+		dirty.version = version;
+		for(int i = 0; i < 1000; ++i)
+			dirty.values[i] = version;
+		prices.flipWriter();
+		usleep(100);
+	}
+
+	int status;
+	pid_t reaped(waitpid(child, &status, 0));
+	assert(reaped == child); // <
+	assert(WIFEXITED(status) && WEXITSTATUS(status) == 0); // <
+
+	/* Test 4 */
+
+	SharedTripleBuffer<Prices> stamped("stamped", true);
+	SharedMemory::sendFd(sockets[0], stamped.fd());
+	SharedTripleBuffer<Prices> checker(SharedMemory::receiveFd(sockets[1]));
+	assert(checker.integrity() && checker.verify()); // < initial slots are stamped
+	assert(reader.verify()); // < nothing to check
+
+	Prices full = Prices();
+	for(int v = 1; v <= 3; ++v){
+		full.version = v;
+		stamped.update(full);
+		uint64_t version(checker.readLast().version);
+		assert(version == (uint64_t)v && checker.verify()); // <
+	}
+
+	for(int v = 4; v <= 20; ++v){ // in place, only the marked blocks are hashed again
+		Prices& dirty = stamped.dirty();
+		dirty.version = v;
+		dirty.values[v * 40] = v;
+		stamped.markDirty(offsetof(Prices, version), sizeof(uint64_t));
+		stamped.markDirty(offsetof(Prices, values) + v * 40 * sizeof(double), sizeof(double));
+		stamped.flipWriter();
+		uint64_t version(checker.readLast().version);
+		assert(version == (uint64_t)v && checker.verify()); // <
+	}
+
+	Prices& dirty = stamped.dirty();
+	dirty.version = 21;
+	dirty.values[999] = -1; // not marked
+	stamped.markDirty(offsetof(Prices, version), sizeof(uint64_t));
+	stamped.flipWriter();
+	uint64_t version(checker.readLast().version);
+	assert(version == 21 && !checker.verify()); // < caught
+
+	stamped.update(full);
+	version = checker.readLast().version;
+	assert(version == 3 && checker.verify()); // <
+
+	close(sockets[0]);
+	close(sockets[1]);
+
+	return 1;
+}
@@ -0,0 +1,91 @@
+//============================================================================
+// Name        : TestSmallTripleBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : SmallTripleBuffer test class
+//============================================================================
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "SmallTripleBuffer.hxx"
+template class SmallTripleBuffer<36>; // explicit instantiation
+
+using namespace std;
+
+int main() {
+
+	SmallTripleBuffer<36> buffer;
+
+	/* Test 1 */
+
+	assert(buffer.snapSize() == 0); // <
+
+	buffer.update("small", 6);
+
+	buffer.newSnap();
+	assert(buffer.snapSize() == 6); // <
+	assert(strcmp((const char*)buffer.snapData(), "small") == 0); // <
+
+	/* Test 2 */
+
+	string large(1000, 'x');
+	buffer.update(large.c_str(), large.size() + 1);
+
+	buffer.newSnap();
+	assert(buffer.snapSize() == large.size() + 1); // <
+	assert(large == (const char*)buffer.snapData()); // <
+
+	/* Test 3 */
+
+	buffer.update("a", 2);
+	buffer.update(large.c_str(), large.size() + 1);
+	buffer.update("b", 2);
+
+	buffer.newSnap();
+	assert(strcmp((const char*)buffer.snapData(), "b") == 0); // <
+
+	buffer.newSnap();
+	assert(strcmp((const char*)buffer.snapData(), "b") == 0); // <
+
+	/* Test 4 */
+
+	bool refused(false);
+	try {
+		buffer.write(large.c_str(), size_t(UINT32_MAX) + 1); // rejected before anything is copied
+	}
+	catch(length_error&){
+		refused = true;
+	}
+	assert(refused); // <
+	assert(strcmp((const char*)buffer.snapData(), "b") == 0); // <
+
+	return 1;
+}
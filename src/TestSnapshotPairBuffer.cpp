@@ -0,0 +1,121 @@
+//============================================================================
+// Name        : TestSnapshotPairBuffer.cpp
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//				 All rights reserved.
+//
+//				 Redistribution and use in source and binary forms, with or without
+//				 modification, are permitted provided that the following conditions are met:
+//					* Redistributions of source code must retain the above copyright
+//					  notice, this list of conditions and the following disclaimer.
+//					* Redistributions in binary form must reproduce the above copyright
+//					  notice, this list of conditions and the following disclaimer in the
+//					  documentation and/or other materials provided with the distribution.
+//					* Neither the name of the <organization> nor the
+//					  names of its contributors may be used to endorse or promote products
+//					  derived from this software without specific prior written permission.
+//
+//				 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//				 ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//				 WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//				 DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//				 DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//				 (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//				 LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//				 ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//				 (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//				 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Description : SnapshotPairBuffer test class
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <thread>
+
+#include "SnapshotPairBuffer.hxx"
+template class SnapshotPairBuffer<int>; // explicit instantiation
+
+using namespace std;
+
+struct Pose
+{
+	uint64_t step;
+	double x;
+	double check; // x * 2, to catch torn values
+};
+
+int main() {
+
+	SnapshotPairBuffer<int> buffer(0);
+
+	/* Test 1 */
+
+	bool fresh(buffer.newSnap());
+	assert(!fresh); // <
+	assert(buffer.latest() == 0 && buffer.previous() == 0); // <
+
+	buffer.update(1);
+	fresh = buffer.newSnap();
+	assert(fresh); // <
+	assert(buffer.latest() == 1 && buffer.previous() == 0); // <
+	assert(buffer.latestSeq() == 1 && buffer.previousSeq() == 0 && buffer.previousTime() == 0); // <
+
+	buffer.update(2);
+	fresh = buffer.newSnap();
+	assert(fresh); // <
+	assert(buffer.latest() == 2 && buffer.previous() == 1); // <
+	assert(buffer.latestTime() >= buffer.previousTime()); // <
+
+	/* Test 2 */
+
+	for(int v = 3; v <= 9; ++v)
+		buffer.update(v);
+	fresh = buffer.newSnap();
+	assert(fresh); // <
+	assert(buffer.latest() == 9 && buffer.previous() == 8); // < adjacent even when conflated
+	fresh = buffer.newSnap();
+	assert(!fresh && buffer.latest() == 9 && buffer.previous() == 8); // <
+
+	buffer.update(10);
+	buffer.newSnap();
+	assert(buffer.latest() == 10 && buffer.previous() == 9); // <
+
+	buffer.update(11);
+	buffer.update(12);
+	buffer.newSnap();
+	assert(buffer.latest() == 12 && buffer.previous() == 11); // <
+
+	/* Test 3 */
+
+	SnapshotPairBuffer<Pose> poses;
+	const uint64_t steps(50000);
+
+	thread simulation([&](){
+		for(uint64_t step = 1; step <= steps; ++step){
+			Pose& pose = poses.dirty();
+			pose.step = step;
+			pose.x = step * 0.25;
+			pose.check = pose.x * 2;
+			poses.flipWriter();
+		}
+	});
+
+	uint64_t last(0);
+	while(last != steps){
+		if(!poses.newSnap())
+			continue;
+		const Pose& latest = poses.latest();
+		const Pose& previous = poses.previous();
+		assert(latest.step > last); // <
+		assert(latest.step == previous.step + 1 || latest.step == 1); // < two most recent published
+		assert(latest.check == latest.x * 2 && previous.check == previous.x * 2); // < not torn
+		assert(poses.latestSeq() == latest.step && poses.previousSeq() == previous.step); // <
+		assert(poses.latestTime() >= poses.previousTime()); // <
+		last = latest.step;
+	}
+	simulation.join();
+
+	return 1;
+}
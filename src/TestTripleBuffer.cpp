@@ -31,12 +31,24 @@
 //============================================================================
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <tuple>
 
 #include "TripleBuffer.hxx"
 template class TripleBuffer<int>; // explicit instantiation
 
 using namespace std;
 
+struct Wide
+{
+	uint64_t seq;
+	double bid;
+	double ask;
+	char padding[4096];
+};
+
 int main() {
 
 	TripleBuffer<int> buffer(0);
@@ -80,6 +92,153 @@ int main() {
 	buffer.newSnap();
 	assert(buffer.snap() == 8); // <
 
+	/* Test 4 */
+
+	TripleBuffer<int> sequenced(0);
+	assert(sequenced.snapSeq() == 0); // <
+
+	sequenced.update(1);
+	sequenced.update(2);
+	sequenced.newSnap();
+	assert(sequenced.snapSeq() == 2); // <
+
+	sequenced.update(3);
+	assert(sequenced.snapSeq() == 2); // <
+	sequenced.newSnap();
+	assert(sequenced.snapSeq() == 3); // <
+
+	/* Test 5 */
+
+	FlightRecorder writerLog("writer"), readerLog("reader");
+	sequenced.recordWriter(&writerLog);
+	sequenced.recordReader(&readerLog);
+
+	sequenced.update(4);
+	sequenced.update(5);
+	sequenced.newSnap();
+	sequenced.newSnap(); // nothing new, not logged
+	assert(writerLog.recorded() == 2 && readerLog.recorded() == 1); // <
+	assert(writerLog.events()[1].seq == 5 && writerLog.events()[1].kind == FlightRecorder::Flip); // <
+	assert(readerLog.events()[0].seq == 5 && readerLog.events()[0].kind == FlightRecorder::Snap); // <
+
+	sequenced.recordWriter(nullptr);
+	sequenced.update(6);
+	assert(writerLog.recorded() == 2); // <
+
+	/* Test 6 */
+
+	TripleBuffer<Wide> wide;
+	Wide value = Wide();
+	value.seq = 1;
+	value.bid = 99.5;
+	value.ask = 100.5;
+	wide.update(value);
+
+	assert(wide.snap(&Wide::seq) == 0); // < not swapped yet
+	double bid(wide.readLast(&Wide::bid));
+	assert(bid == 99.5); // <
+
+	value.seq = 2;
+	value.ask = 101;
+	wide.update(value);
+	tuple<uint64_t, double, double> quote(wide.readLast(&Wide::seq, &Wide::bid, &Wide::ask));
+	assert(get<0>(quote) == 2 && get<1>(quote) == 99.5 && get<2>(quote) == 101); // <
+
+	value.seq = 3;
+	value.bid = 100;
+	wide.update(value);
+	double spread(wide.visitLast([](const Wide& w){ return w.ask - w.bid; }));
+	assert(spread == 1); // <
+	assert(get<0>(wide.snap(&Wide::seq, &Wide::bid)) == 3); // <
+
+	/* Test 7 */
+
+	TripleBuffer<int> state(0);
+	assert(state.lastPublished() == 0); // <
+	state.waitForVersion(0); // initial value
+	bool reached(state.waitForVersion(1, chrono::milliseconds(1)));
+	assert(!reached); // < timed out
+
+	thread applier([&](){
+		for(int v = 1; v <= 1000; ++v)
+			state.update(v);
+		assert(state.lastPublished() == 1000); // <
+	});
+	state.waitForVersion(500);
+	assert(state.snapSeq() >= 500 && state.snap() >= 500); // <
+	reached = state.waitForVersion(1000, chrono::seconds(10));
+	assert(reached); // <
+	assert(state.snap() == 1000); // <
+	applier.join();
+
+	/* Test 8 */
+
+	TripleBuffer<int> credits(0);
+	assert(credits.lastConsumed() == 0); // <
+	credits.update(1);
+	credits.update(2);
+	assert(credits.lastConsumed() == 0); // < published, not taken
+	bool acknowledged(credits.waitConsumed(2, chrono::milliseconds(1)));
+	assert(!acknowledged); // <
+	credits.newSnap();
+	assert(credits.lastConsumed() == 2); // <
+	credits.waitConsumed(2);
+
+	thread consumer([&](){
+		while(credits.snap() != 100)
+			credits.newSnap();
+	});
+	for(int v = 3; v <= 100; ++v){
+		credits.update(v);
+		credits.waitConsumed(credits.lastPublished()); // one value in flight at a time
+	}
+	consumer.join();
+	assert(credits.lastConsumed() == 100); // <
+
+	/* Test 9 */
+
+	TripleBuffer<Wide> monitored;
+	Wide sample;
+	uint64_t observed(monitored.observe(sample));
+	assert(observed == 0 && sample.seq == 0); // <
+
+	value.seq = 1;
+	value.bid = 1;
+	memset(value.padding, 1, sizeof(value.padding));
+	monitored.update(value);
+	observed = monitored.observe(sample);
+	assert(observed == 1 && sample.seq == 1); // < not taken yet, still seen
+	bool taken(monitored.newSnap());
+	assert(taken && monitored.snap(&Wide::seq) == 1); // < the reader still gets it
+	observed = monitored.observe(sample);
+	assert(observed == 1); // < now from the snap
+	taken = monitored.newSnap();
+	assert(!taken); // <
+
+	thread producer([&](){
+		Wide w = Wide();
+		for(uint64_t v = 2; v <= 20000; ++v){
+			w.seq = v;
+			w.bid = v;
+			memset(w.padding, static_cast<int>(v & 0xff), sizeof(w.padding));
+			monitored.update(w);
+		}
+	});
+
+	uint64_t lastSeen(1), lastTaken(1);
+	while(lastTaken != 20000){
+		uint64_t seen(monitored.observe(sample));
+		assert(seen >= lastSeen && sample.seq == seen && sample.bid == seen); // < consistent copy
+		assert(sample.padding[0] == char(seen & 0xff) && sample.padding[4095] == char(seen & 0xff)); // <
+		lastSeen = seen;
+
+		if(monitored.newSnap()){
+			assert(monitored.snapSeq() > lastTaken); // < the observer stole nothing
+			lastTaken = monitored.snapSeq();
+		}
+	}
+	producer.join();
+
 	return 1;
 }
 
@@ -34,6 +34,15 @@
 #define TRIPLEBUFFER_HXX_
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "FlightRecorder.hxx"
+#include "TripleBufferFlags.hxx"
 
 using namespace std;
 
@@ -51,88 +60,124 @@ public:
 	TripleBuffer<T>& operator=(const TripleBuffer<T>&) = delete;
 
 	T snap() const; // get the current snap to read
+	const T& snapRef() const; // get the current snap without copying it, valid until the next newSnap
+	uint64_t snapSeq() const; // sequence number of the current snap, 0 for the initial value
 	void write(const T newT); // write a new value
+	T& dirty(); // get the dirty slot to write into in place
 	bool newSnap(); // swap to the latest value, if any
 	void flipWriter(); // flip writer positions dirty / clean
 
 	T readLast(); // wrapper to read the last available element (newSnap + snap)
 	void update(T newT); // wrapper to update with a new element (write + flipWriter)
 
+	void waitForVersion(uint64_t seq); // reader: spin until the snap has a sequence number >= seq
+	template <typename Rep, typename Period> bool waitForVersion(uint64_t seq, chrono::duration<Rep, Period> timeout); // same, false on timeout
+	uint64_t lastPublished() const; // writer: sequence number of the last value published
+	uint64_t lastConsumed() const; // writer: sequence number of the last value the reader took with newSnap
+	void waitConsumed(uint64_t seq); // writer: spin until the reader took a value with a sequence number >= seq
+	template <typename Rep, typename Period> bool waitConsumed(uint64_t seq, chrono::duration<Rep, Period> timeout); // same, false on timeout
+
+	// projections, copying only some members of a wide T (or of its bases C) out of the snap
+	template <typename M, typename C> M snap(M C::*field) const; // get one member of the current snap
+	template <typename... M, typename... C> tuple<M...> snap(M C::*... fields) const; // get some members of the current snap
+	template <typename M, typename C> M readLast(M C::*field); // newSnap + snap(field)
+	template <typename... M, typename... C> tuple<M...> readLast(M C::*... fields); // newSnap + snap(fields...)
+	template <typename F> auto visitLast(F visitor) -> decltype(visitor(declval<const T&>())); // newSnap + visitor(snap) in place
+
+	uint64_t observe(T& out) const; // monitor: copy the latest value without taking it, returns its sequence number (T trivially copyable)
+	uint64_t latestSeq() const; // monitor: sequence number of the latest value published, may be stale by the time it returns
+
+	void recordWriter(FlightRecorder* log); // writer: log every flip into log, nullptr to stop
+	void recordReader(FlightRecorder* log); // reader: log every fresh snap into log, nullptr to stop
+
 private:
 
-	bool isNewWrite(uint_fast8_t flags); // check if the newWrite bit is 1
-	uint_fast8_t swapSnapWithClean(uint_fast8_t flags); // swap Snap and Clean indexes
-	uint_fast8_t newWriteSwapCleanWithDirty(uint_fast8_t flags); // set newWrite to 1 and swap Clean and Dirty indexes
+	TripleBufferFlags flags; // dirty / clean / snap indexes
 
-	// 8 bit flags are (unused) (new write) (2x dirty) (2x clean) (2x snap)
-	// newWrite   = (flags & 0x40)
-	// dirtyIndex = (flags & 0x30) >> 4
-	// cleanIndex = (flags & 0xC) >> 2
-	// snapIndex  = (flags & 0x3)
-	mutable atomic_uint_fast8_t flags;
+	uint64_t written; // writer only, number of values published so far
+	atomic<uint64_t> seq[3]; // sequence number of the value held by each slot, set by flipWriter, atomic for observe
+
+	FlightRecorder* writerLog; // writer only, opt-in event logs
+	FlightRecorder* readerLog; // reader only
 
 	T buffer[3];
+
+	// written by the reader on every fresh snap, read by the writer only when asked.
+	// Padded on both sides to get a line of its own rather than aligned, so plain
+	// new still works for a TripleBuffer in C++11.
+	unsigned char consumedBefore[TRIPLEBUFFER_CACHE_LINE_SIZE];
+	atomic<uint64_t> consumed;
+	unsigned char consumedAfter[TRIPLEBUFFER_CACHE_LINE_SIZE - sizeof(atomic<uint64_t>)];
 };
 
 // include implementation in header since it is a template
 
 template <typename T>
-TripleBuffer<T>::TripleBuffer(){
-
-	T dummy = T();
-
-	buffer[0] = dummy;
-	buffer[1] = dummy;
-	buffer[2] = dummy;
-
-	flags.store(0x6, std::memory_order_relaxed); // initially dirty = 0, clean = 1 and snap = 2
+TripleBuffer<T>::TripleBuffer() : written(0), seq(), writerLog(nullptr), readerLog(nullptr), buffer(), consumed(0){
+	// slots are value initialized in place, T needs not be copyable to be built in the dirty slot
 }
 
 template <typename T>
-TripleBuffer<T>::TripleBuffer(const T& init){
+TripleBuffer<T>::TripleBuffer(const T& init) : written(0), seq(), writerLog(nullptr), readerLog(nullptr), consumed(0){
 
 	buffer[0] = init;
 	buffer[1] = init;
 	buffer[2] = init;
-
-	flags.store(0x6, std::memory_order_relaxed); // initially dirty = 0, clean = 1 and snap = 2
 }
 
 template <typename T>
 T TripleBuffer<T>::snap() const{
 
-	return buffer[flags.load(std::memory_order_consume) & 0x3]; // read snap index
+	return buffer[flags.snapIndex()]; // read snap index
+}
+
+template <typename T>
+const T& TripleBuffer<T>::snapRef() const{
+
+	return buffer[flags.snapIndex()]; // read snap index
+}
+
+template <typename T>
+uint64_t TripleBuffer<T>::snapSeq() const{
+
+	return seq[flags.snapIndex()].load(memory_order_relaxed); // read snap index
 }
 
 template <typename T>
 void TripleBuffer<T>::write(const T newT){
 
-	buffer[(flags.load(std::memory_order_consume) & 0x30) >> 4] = newT; // write into dirty index
+	buffer[flags.dirtyIndex()] = newT; // write into dirty index
+}
+
+template <typename T>
+T& TripleBuffer<T>::dirty(){
+
+	return buffer[flags.dirtyIndex()]; // dirty index
 }
 
 template <typename T>
 bool TripleBuffer<T>::newSnap(){
 
-	uint_fast8_t flagsNow(flags.load(std::memory_order_consume));
-	do {
-		if( !isNewWrite(flagsNow) ) // nothing new, no need to swap
-			return false;
-	} while(!flags.compare_exchange_weak(flagsNow,
-			    swapSnapWithClean(flagsNow),
-			    memory_order_release,
-			    memory_order_consume));
+	unsigned retries;
+	if(!flags.newSnap(retries))
+		return false;
 
+	uint64_t taken(snapSeq());
+	consumed.store(taken, memory_order_release);
+	if(readerLog)
+		readerLog->record(FlightRecorder::Snap, taken, retries);
 	return true;
 }
 
 template <typename T>
 void TripleBuffer<T>::flipWriter(){
 
-	uint_fast8_t flagsNow(flags.load(std::memory_order_consume));
-	while(!flags.compare_exchange_weak(flagsNow,
-			  newWriteSwapCleanWithDirty(flagsNow),
-			  memory_order_release,
-			  memory_order_consume));
+	seq[flags.dirtyIndex()].store(++written, memory_order_relaxed); // published along with the slot by the flip
+
+	unsigned retries;
+	flags.flipWriter(retries);
+	if(writerLog)
+		writerLog->record(FlightRecorder::Flip, written, retries);
 }
 
 template <typename T>
@@ -148,21 +193,140 @@ void TripleBuffer<T>::update(T newT){
 }
 
 template <typename T>
-bool TripleBuffer<T>::isNewWrite(uint_fast8_t flags){
-	// check if the newWrite bit is 1
-	return ((flags & 0x40) != 0);
+template <typename M, typename C>
+M TripleBuffer<T>::snap(M C::*field) const{
+
+	return buffer[flags.snapIndex()].*field; // read snap index
+}
+
+template <typename T>
+template <typename... M, typename... C>
+tuple<M...> TripleBuffer<T>::snap(M C::*... fields) const{
+
+	const T& current(buffer[flags.snapIndex()]); // read snap index
+	return tuple<M...>(current.*fields...);
+}
+
+template <typename T>
+template <typename M, typename C>
+M TripleBuffer<T>::readLast(M C::*field){
+	newSnap(); // get most recent value
+	return snap(field); // return the member
+}
+
+template <typename T>
+template <typename... M, typename... C>
+tuple<M...> TripleBuffer<T>::readLast(M C::*... fields){
+	newSnap(); // get most recent value
+	return snap(fields...); // return the members
+}
+
+template <typename T>
+template <typename F>
+auto TripleBuffer<T>::visitLast(F visitor) -> decltype(visitor(declval<const T&>())){
+	newSnap(); // get most recent value
+	return visitor(snapRef()); // let the visitor pick what it needs
+}
+
+template <typename T>
+void TripleBuffer<T>::waitForVersion(uint64_t seq){
+
+	unsigned long spins(0);
+	while(snapSeq() < seq){
+		if(!newSnap())
+			TripleBufferFlags::backoff(spins);
+	}
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+bool TripleBuffer<T>::waitForVersion(uint64_t seq, chrono::duration<Rep, Period> timeout){
+
+	chrono::steady_clock::time_point deadline(chrono::steady_clock::now() + timeout);
+	unsigned long spins(0);
+	while(snapSeq() < seq){
+		if(newSnap())
+			continue;
+		if(spins % 64 == 0 && chrono::steady_clock::now() >= deadline) // clock reads are not free
+			return false;
+		TripleBufferFlags::backoff(spins);
+	}
+	return true;
+}
+
+template <typename T>
+uint64_t TripleBuffer<T>::observe(T& out) const{
+
+	static_assert(is_trivially_copyable<T>::value, "observe copies slots the writer may be reusing");
+
+	// seqlock style: the copy is good if the slot was not handed back to the
+	// writer meanwhile, and was not written and published again since. Writes
+	// into a slot follow the flip that made it dirty (flipWriter ends with a
+	// release fence), so a copy that read any of them fails the second check
+	unsigned long spins(0);
+	for(;;){
+		uint_fast8_t latest(flags.latestIndex());
+		uint64_t before(seq[latest].load(memory_order_acquire));
+		if(flags.dirtyIndex() != latest){
+			memcpy(static_cast<void*>(&out), &buffer[latest], sizeof(T));
+			atomic_thread_fence(memory_order_acquire);
+			if(flags.dirtyIndex() != latest && seq[latest].load(memory_order_relaxed) == before)
+				return before;
+		}
+		TripleBufferFlags::backoff(spins);
+	}
 }
 
 template <typename T>
-uint_fast8_t TripleBuffer<T>::swapSnapWithClean(uint_fast8_t flags){
-	// swap snap with clean
-	return (flags & 0x30) | ((flags & 0x3) << 2) | ((flags & 0xC) >> 2);
+uint64_t TripleBuffer<T>::latestSeq() const{
+
+	return seq[flags.latestIndex()].load(memory_order_relaxed); // set before the flip latestIndex acquires
+}
+
+template <typename T>
+uint64_t TripleBuffer<T>::lastPublished() const{
+
+	return written;
 }
 
 template <typename T>
-uint_fast8_t TripleBuffer<T>::newWriteSwapCleanWithDirty(uint_fast8_t flags){
-	// set newWrite bit to 1 and swap clean with dirty
-	return 0x40 | ((flags & 0xC) << 2) | ((flags & 0x30) >> 2) | (flags & 0x3);
+uint64_t TripleBuffer<T>::lastConsumed() const{
+
+	return consumed.load(memory_order_acquire);
+}
+
+template <typename T>
+void TripleBuffer<T>::waitConsumed(uint64_t seq){
+
+	unsigned long spins(0);
+	while(lastConsumed() < seq)
+		TripleBufferFlags::backoff(spins);
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+bool TripleBuffer<T>::waitConsumed(uint64_t seq, chrono::duration<Rep, Period> timeout){
+
+	chrono::steady_clock::time_point deadline(chrono::steady_clock::now() + timeout);
+	unsigned long spins(0);
+	while(lastConsumed() < seq){
+		if(spins % 64 == 0 && chrono::steady_clock::now() >= deadline) // clock reads are not free
+			return false;
+		TripleBufferFlags::backoff(spins);
+	}
+	return true;
+}
+
+template <typename T>
+void TripleBuffer<T>::recordWriter(FlightRecorder* log){
+
+	writerLog = log;
+}
+
+template <typename T>
+void TripleBuffer<T>::recordReader(FlightRecorder* log){
+
+	readerLog = log;
 }
 
 #endif /* TRIPLEBUFFER_HXX_ */
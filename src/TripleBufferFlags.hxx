@@ -0,0 +1,200 @@
+//============================================================================
+// Name        : TripleBufferFlags.hxx
+// Author      : André Pacheco Neves
+// Version     : 1.0 (18/10/26)
+// Copyright   : Copyright (c) 2013, André Pacheco Neves
+//               All rights reserved.
+//
+//               Redistribution and use in source and binary forms, with or without
+//               modification, are permitted provided that the following conditions are met:
+//               	* Redistributions of source code must retain the above copyright
+//               	  notice, this list of conditions and the following disclaimer.
+//               	* Redistributions in binary form must reproduce the above copyright
+//               	  notice, this list of conditions and the following disclaimer in the
+//               	  documentation and/or other materials provided with the distribution.
+//               	* Neither the name of the <organization> nor the
+//               	  names of its contributors may be used to endorse or promote products
+//               	  derived from this software without specific prior written permission.
+//
+//               THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+//               ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+//               WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//               DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+//               DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+//               (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+//               LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+//               ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+//               (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+//               SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Description : Lock-free dirty / clean / snap index protocol shared by the TripleBuffer layouts
+//============================================================================
+
+#ifndef TRIPLEBUFFERFLAGS_HXX_
+#define TRIPLEBUFFERFLAGS_HXX_
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+using namespace std;
+
+// cache line size used to lay out the buffers, override with -D for other architectures
+#ifndef TRIPLEBUFFER_CACHE_LINE_SIZE
+#define TRIPLEBUFFER_CACHE_LINE_SIZE 64
+#endif
+
+// Lock-free index protocol shared by every triple buffer layout. It only manages
+// which of the three slots is dirty, clean and snap, the storage is up to the user.
+class TripleBufferFlags
+{
+
+public:
+
+	TripleBufferFlags();
+	TripleBufferFlags(uint_fast8_t dirty, uint_fast8_t clean, uint_fast8_t snap); // start from given indexes with nothing new, e.g. when recovering slots
+
+	// non-copyable behavior
+	TripleBufferFlags(const TripleBufferFlags&) = delete;
+	TripleBufferFlags& operator=(const TripleBufferFlags&) = delete;
+
+	uint_fast8_t dirtyIndex() const; // index the writer should write into
+	uint_fast8_t snapIndex() const; // index the reader should read from
+	uint_fast8_t latestIndex() const; // index of the latest value published, clean if the reader did not take it yet, snap otherwise
+	bool newSnap(); // swap to the latest value, if any
+	bool newSnap(unsigned& retries); // same, counting the failed exchanges
+	void flipWriter(); // flip writer positions dirty / clean
+	void flipWriter(unsigned& retries); // same, counting the failed exchanges
+
+	static void relax(); // spin-wait hint for loops polling the flags
+	static void backoff(unsigned long& spins); // relax, yielding the thread now and then on long waits
+
+	// the protocol on a flags byte, for layouts packing several of them in one atomic word
+	static const uint_fast8_t Initial = 0x6; // initially dirty = 0, clean = 1 and snap = 2
+	static uint_fast8_t dirtyOf(uint_fast8_t flags); // dirty index in flags
+	static uint_fast8_t snapOf(uint_fast8_t flags); // snap index in flags
+	static bool isNewWrite(uint_fast8_t flags); // check if the newWrite bit is 1
+	static uint_fast8_t swapSnapWithClean(uint_fast8_t flags); // swap Snap and Clean indexes
+	static uint_fast8_t newWriteSwapCleanWithDirty(uint_fast8_t flags); // set newWrite to 1 and swap Clean and Dirty indexes
+
+private:
+
+	// 8 bit flags are (unused) (new write) (2x dirty) (2x clean) (2x snap)
+	// newWrite   = (flags & 0x40)
+	// dirtyIndex = (flags & 0x30) >> 4
+	// cleanIndex = (flags & 0xC) >> 2
+	// snapIndex  = (flags & 0x3)
+	mutable atomic_uint_fast8_t flags;
+};
+
+inline TripleBufferFlags::TripleBufferFlags(){
+
+	flags.store(Initial, std::memory_order_relaxed); // initially dirty = 0, clean = 1 and snap = 2
+}
+
+inline TripleBufferFlags::TripleBufferFlags(uint_fast8_t dirty, uint_fast8_t clean, uint_fast8_t snap){
+
+	flags.store(static_cast<uint_fast8_t>(dirty << 4 | clean << 2 | snap), std::memory_order_relaxed);
+}
+
+inline uint_fast8_t TripleBufferFlags::dirtyIndex() const{
+
+	return dirtyOf(flags.load(std::memory_order_consume)); // read dirty index
+}
+
+inline uint_fast8_t TripleBufferFlags::snapIndex() const{
+
+	return snapOf(flags.load(std::memory_order_consume)); // read snap index
+}
+
+inline uint_fast8_t TripleBufferFlags::latestIndex() const{
+
+	uint_fast8_t flagsNow(flags.load(std::memory_order_acquire));
+	return isNewWrite(flagsNow) ? (flagsNow & 0xC) >> 2 : snapOf(flagsNow); // read clean or snap index
+}
+
+inline bool TripleBufferFlags::newSnap(){
+
+	unsigned retries;
+	return newSnap(retries);
+}
+
+inline bool TripleBufferFlags::newSnap(unsigned& retries){
+
+	retries = 0;
+	uint_fast8_t flagsNow(flags.load(std::memory_order_consume));
+	while(isNewWrite(flagsNow)){ // otherwise nothing new, no need to swap
+		if(flags.compare_exchange_weak(flagsNow,
+			   swapSnapWithClean(flagsNow),
+			   memory_order_release,
+			   memory_order_consume))
+			return true;
+		++retries;
+	}
+
+	return false;
+}
+
+inline void TripleBufferFlags::flipWriter(){
+
+	unsigned retries;
+	flipWriter(retries);
+}
+
+inline void TripleBufferFlags::flipWriter(unsigned& retries){
+
+	retries = 0;
+	uint_fast8_t flagsNow(flags.load(std::memory_order_consume));
+	while(!flags.compare_exchange_weak(flagsNow,
+			  newWriteSwapCleanWithDirty(flagsNow),
+			  memory_order_release,
+			  memory_order_consume))
+		++retries;
+
+	// seqlock writer: the flip must be visible before any write into the new dirty
+	// slot, so an observer that read such a write also sees the slot handed over
+	atomic_thread_fence(std::memory_order_release);
+}
+
+inline void TripleBufferFlags::relax(){
+
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+inline void TripleBufferFlags::backoff(unsigned long& spins){
+
+	if(++spins % 1024 == 0) // long wait, let the other side run if it shares our core
+		this_thread::yield();
+	else
+		relax();
+}
+
+inline uint_fast8_t TripleBufferFlags::dirtyOf(uint_fast8_t flags){
+
+	return (flags & 0x30) >> 4;
+}
+
+inline uint_fast8_t TripleBufferFlags::snapOf(uint_fast8_t flags){
+
+	return flags & 0x3;
+}
+
+inline bool TripleBufferFlags::isNewWrite(uint_fast8_t flags){
+	// check if the newWrite bit is 1
+	return ((flags & 0x40) != 0);
+}
+
+inline uint_fast8_t TripleBufferFlags::swapSnapWithClean(uint_fast8_t flags){
+	// swap snap with clean
+	return (flags & 0x30) | ((flags & 0x3) << 2) | ((flags & 0xC) >> 2);
+}
+
+inline uint_fast8_t TripleBufferFlags::newWriteSwapCleanWithDirty(uint_fast8_t flags){
+	// set newWrite bit to 1 and swap clean with dirty
+	return 0x40 | ((flags & 0xC) << 2) | ((flags & 0x30) >> 2) | (flags & 0x3);
+}
+
+#endif /* TRIPLEBUFFERFLAGS_HXX_ */